@@ -0,0 +1,144 @@
+# Converts utils/rooms.txt and utils/connections.txt into a header of constexpr
+# tables (see utils/StaticMap.h). Parsing mirrors
+# CoordinateMapSystem::loadRoomsFromFile / loadConnectionsFromFile.
+
+set(_NAVIGATION_ROOM_TYPES CLASSROOM LABORATORY OFFICE TOILET STAIRCASE CORRIDOR ENTRANCE)
+
+function(_navigation_escape_literal out value)
+    string(REPLACE "\\" "\\\\" value "${value}")
+    string(REPLACE "\"" "\\\"" value "${value}")
+    set(${out} "${value}" PARENT_SCOPE)
+endfunction()
+
+function(navigation_embed_map rooms_file connections_file output_file)
+    file(STRINGS "${rooms_file}" room_lines ENCODING UTF-8)
+    file(STRINGS "${connections_file}" connection_lines ENCODING UTF-8)
+
+    # Lines are split into CMake lists on '|', so a literal ';' (a room name like
+    # "Lab; Wing B") would split a field. It is swapped for a control character
+    # while parsing and put back when the row is written.
+    string(ASCII 31 semicolon)
+
+    # ---------- Rooms ----------
+    set(room_ids "")
+    foreach(line IN LISTS room_lines)
+        string(STRIP "${line}" line)
+        if(line STREQUAL "" OR line MATCHES "^#")
+            continue()
+        endif()
+
+        string(REPLACE ";" "${semicolon}" fields "${line}")
+        string(REPLACE "|" ";" fields "${fields}")
+        list(LENGTH fields field_count)
+        if(field_count LESS 7)
+            message(WARNING "EmbedMap: skipping malformed room line: ${line}")
+            continue()
+        endif()
+
+        list(GET fields 0 id)
+        list(GET fields 1 name)
+        list(GET fields 2 type)
+        string(STRIP "${id}" id)
+        string(STRIP "${name}" name)
+        string(STRIP "${type}" type)
+        string(TOUPPER "${type}" type)
+
+        # Ids become CMake variable names and list entries, so ';' can't be kept.
+        if(id MATCHES "${semicolon}")
+            message(FATAL_ERROR "EmbedMap: room ids may not contain ';': ${id}")
+        endif()
+
+        if(NOT type IN_LIST _NAVIGATION_ROOM_TYPES)
+            message(WARNING "EmbedMap: skipping room ${id} due to invalid type: ${type}")
+            continue()
+        endif()
+        if(id IN_LIST room_ids)
+            message(WARNING "EmbedMap: duplicate room ${id}, keeping the first definition")
+            continue()
+        endif()
+
+        set(coords "")
+        foreach(i RANGE 3 6)
+            list(GET fields ${i} v)
+            string(STRIP "${v}" v)
+            if(NOT v MATCHES "^-?[0-9]+(\\.[0-9]*)?$")
+                message(FATAL_ERROR "EmbedMap: room ${id} has a non-numeric field: ${v}")
+            endif()
+            list(APPEND coords "${v}")
+        endforeach()
+
+        list(APPEND room_ids "${id}")
+        _navigation_escape_literal(name "${name}")
+        set("_room_${id}" "\"${name}\", RoomType::${type}, ${coords}")
+    endforeach()
+
+    list(LENGTH room_ids room_count)
+    if(room_count EQUAL 0)
+        message(FATAL_ERROR "EmbedMap: no rooms found in ${rooms_file}")
+    endif()
+
+    set(sorted_ids ${room_ids})
+    list(SORT sorted_ids)
+
+    set(room_rows "")
+    foreach(id IN LISTS sorted_ids)
+        string(REPLACE ";" ", " fields "${_room_${id}}")
+        string(REPLACE "${semicolon}" ";" fields "${fields}")
+        _navigation_escape_literal(escaped_id "${id}")
+        string(APPEND room_rows "        { \"${escaped_id}\", ${fields} },\n")
+    endforeach()
+
+    # ---------- Connections ----------
+    set(edge_rows "")
+    set(edge_count 0)
+    foreach(line IN LISTS connection_lines)
+        string(STRIP "${line}" line)
+        if(line STREQUAL "" OR line MATCHES "^#")
+            continue()
+        endif()
+
+        string(REPLACE ";" "${semicolon}" fields "${line}")
+        string(REPLACE "|" ";" fields "${fields}")
+        list(LENGTH fields field_count)
+        if(field_count LESS 3)
+            continue()
+        endif()
+
+        list(GET fields 0 a)
+        list(GET fields 1 b)
+        string(STRIP "${a}" a)
+        string(STRIP "${b}" b)
+        list(FIND sorted_ids "${a}" ia)
+        list(FIND sorted_ids "${b}" ib)
+        if(ia EQUAL -1 OR ib EQUAL -1)
+            message(FATAL_ERROR "EmbedMap: connection references an unknown room: ${line}")
+        endif()
+
+        string(APPEND edge_rows "        { ${ia}, ${ib} },\n")
+        math(EXPR edge_count "${edge_count} + 1")
+    endforeach()
+
+    if(edge_count EQUAL 0)
+        message(FATAL_ERROR "EmbedMap: no connections found in ${connections_file}")
+    endif()
+
+    set(content "// Generated by cmake/EmbedMap.cmake from\n")
+    string(APPEND content "//   ${rooms_file}\n//   ${connections_file}\n")
+    string(APPEND content "// Do not edit; reconfigure to regenerate.\n")
+    string(APPEND content "#pragma once\n\n#include \"utils/StaticMap.h\"\n\n")
+    string(APPEND content "namespace NavigationVI::EmbeddedMap{\n")
+    string(APPEND content "    inline constexpr StaticRoom EMBEDDED_ROOMS[] = {\n${room_rows}    };\n\n")
+    string(APPEND content "    inline constexpr StaticEdgeRef EMBEDDED_EDGES[] = {\n${edge_rows}    };\n\n")
+    string(APPEND content "    static_assert(StaticMapDetail::isSortedById(EMBEDDED_ROOMS), \"rooms must be sorted by id\");\n\n")
+    string(APPEND content "    inline constexpr auto EMBEDDED_GRAPH = buildStaticGraph(EMBEDDED_ROOMS, EMBEDDED_EDGES);\n")
+    string(APPEND content "    inline constexpr auto EMBEDDED_TURNS = buildTurnTable<countTurnPairs(EMBEDDED_GRAPH)>(EMBEDDED_ROOMS, EMBEDDED_GRAPH);\n")
+    string(APPEND content "    inline constexpr StaticMapView EMBEDDED_MAP = makeStaticMapView(EMBEDDED_ROOMS, EMBEDDED_GRAPH, EMBEDDED_TURNS);\n")
+    string(APPEND content "}\n")
+
+    # Only touch the file when the tables change so reconfiguring doesn't force a rebuild.
+    file(WRITE "${output_file}.tmp" "${content}")
+    configure_file("${output_file}.tmp" "${output_file}" COPYONLY)
+    file(REMOVE "${output_file}.tmp")
+
+    message(STATUS "EmbedMap: ${room_count} rooms, ${edge_count} connections -> ${output_file}")
+endfunction()
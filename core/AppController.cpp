@@ -1,19 +1,33 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
+#include <iomanip>
+#include <fstream>
 #include <algorithm>
 
 #include "AppController.h"
 #include "../modules/TextToSpeech.h"
+#ifdef NAVIGATION_HAVE_LIBJPEG
+#include "../modules/MjpegSource.h"
+#endif
+
+#ifdef NAVIGATION_EMBEDDED_MAP
+#include "EmbeddedMap.h"
+#endif
 
 #include <thread>
 #include <mutex>
 #include <queue>
 #include <condition_variable>
 #include <atomic>
+#include <csignal>
+#include <memory>
+#include <utility>
 
 struct TTSItem {
     std::string text{};
     enum class Type { Nav, Announce } type;
+    // Capture time of the first frame showing the code this answers, if any.
+    std::chrono::steady_clock::time_point visibleAt{};
 };
 
 enum class TTSEngine{
@@ -24,19 +38,20 @@ enum class TTSEngine{
 
 using namespace NavigationVI;
 
-std::queue<cv::Mat> frameQueue{};
-std::mutex frameMutex{};
-std::condition_variable frameCV{};
-
 std::queue<TTSItem> ttsQueue{};
 std::mutex ttsMutex{};
 std::condition_variable ttsCV{};
 
 std::atomic<bool> running{ true };
 
+// Set by SIGINT/SIGTERM; the capture loop checks it once per frame.
+volatile std::sig_atomic_t stopRequested{ 0 };
+extern "C" void onStopSignal(int) { stopRequested = 1; }
+
 cv::Mat lastQRROI{};
 
 std::mutex stateMutex{};
+std::mutex mapMutex{};
 cv::Rect lastBBox{};
 std::string lastInstruction{};
 
@@ -56,6 +71,9 @@ constexpr int QR_DECODE_MIN_WIDTH{ 120 };
 constexpr float REF_DISTANCE_M{ 1.0f };
 constexpr float REF_PIXEL_WIDTH{ 140.0f };
 constexpr float TARGET_DISTANCE_M{ 0.3f };
+constexpr double DEFAULT_DETECTION_BUDGET_MS{ 250.0 };
+// An alert code unseen for this long is announced again when it comes back.
+constexpr std::chrono::seconds ALERT_FORGET_AFTER{ 5 };
 
 std::chrono::steady_clock::time_point lastDistanceTTS{ std::chrono::steady_clock::now() };
 
@@ -71,29 +89,38 @@ static inline void toUpperInPlace(std::string& s) {
         [](unsigned char c) { return std::toupper(c); });
 }
 
-cv::Mat AppController::waitForNextFrame() {
-    std::unique_lock<std::mutex> lock(frameMutex);
-    frameCV.wait(lock, [] { return !frameQueue.empty() || !running; });
-    if (!running) return {};
-    cv::Mat frame{ frameQueue.front().clone() };
-    frameQueue.pop();
-    return frame;
+static const std::vector<std::pair<std::string, QRColour>> colourMap{
+    {"red", QRColour::RED},
+    { "green", QRColour::GREEN },
+    { "blue", QRColour::BLUE },
+    { "none", QRColour::NONE }
+};
+
+static inline double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+FrameContext* AppController::waitForNextFrame(FrameRing& ring, int consumer) {
+    // Valid until this consumer's next call; the ring hands the slot back to capture then.
+    return running ? ring.acquire(consumer) : nullptr;
 }
 
-void AppController::updateGuidanceOverlay(const QRCode& qr, const cv::Size& frameSize) {
-    auto cmd{ detector.getNavigationToQR(qr, frameSize) };
+void AppController::updateGuidanceOverlay(const Camera& camera, const QRCode& qr, const cv::Size& frameSize) {
+    auto cmd{ camera.workers.front()->detector.getNavigationToQR(qr, frameSize) };
     std::lock_guard<std::mutex> lock(stateMutex);
     lastInstruction = cmd.instruction;
-    lastBBox = qr.bbox;
+    // Only the first camera is on screen.
+    lastBBox = camera.index == 0 ? qr.bbox : cv::Rect{};
 }
 
-bool AppController::isCloseEnough(const QRCode& qr) const {
-    float currentWidthPx{ static_cast<float>(qr.bbox.width) };
+bool AppController::isCloseEnough(const QRCode& qr, float captureScale) const {
+    float currentWidthPx{ static_cast<float>(qr.bbox.width) * captureScale };
     float estimateDistanceM{ (REF_DISTANCE_M * REF_PIXEL_WIDTH) / currentWidthPx };
     return estimateDistanceM <= TARGET_DISTANCE_M;
 }
 
 cv::Mat AppController::extractQRROI(const QRCode& qr, const cv::Mat& frame) {
+    ScopedLatency timer{ LatencyStage::ExtractRoi };
     if (!qr.corners.empty() && qr.corners.size() == 4) {
         double side{ 0.0f };
         for (int i = 0; i < 4; ++i) {
@@ -113,7 +140,8 @@ cv::Mat AppController::extractQRROI(const QRCode& qr, const cv::Mat& frame) {
         return roi;
     } else {
         cv::Rect roiRect{ qr.bbox & cv::Rect(0, 0, frame.cols, frame.rows) };
-        return (roiRect.width > 0 && roiRect.height > 0) ? frame(roiRect).clone() : cv::Mat{};
+        // A view is enough: QRReader handles strided ROIs and the preview clones.
+        return (roiRect.width > 0 && roiRect.height > 0) ? frame(roiRect) : cv::Mat{};
     }
 }
 
@@ -131,23 +159,61 @@ std::string AppController::decodeQR(const cv::Mat& roi) {
     return content;
 }
 
-void AppController::handleDecodedQR(const std::string& content) {
+// Codes narrower than QR_DECODE_MIN_WIDTH are cropped from the full-resolution
+// frame and upsampled to that width instead of being skipped.
+std::string AppController::decodeMultiScale(Worker& worker, const QRCode& qr, FrameContext& ctx, cv::Mat& roiOut) {
+    // Scaled-down sources decode just this code's box at full resolution.
+    QRCode full{ qr };
+    cv::Mat region{ ctx.fullResolutionRegion(qr.bbox) };
+    if (region.empty()) return {};
+    float s{ static_cast<float>(ctx.fullResolutionScale()) };
+    cv::Point2f origin{ static_cast<float>(qr.bbox.x), static_cast<float>(qr.bbox.y) };
+    for (auto& c : full.corners) c = (c - origin) * s;
+    full.bbox = cv::Rect{ 0, 0, region.cols, region.rows };
+
+    cv::Mat roi{ extractQRROI(full, region) };
+    if (roi.empty()) return {};
+
+    // The same code seen again in about the same place skips ZBar.
+    auto now{ ctx.captureTime() };
+    if (auto cached{ worker.decodeCache.lookup(roi, qr.position, now) }) {
+        roiOut = roi;
+        return *cached;
+    }
+
+    for (double scale : worker.detector.decodeScalesFor(full, QR_DECODE_MIN_WIDTH, s)) {
+        cv::Mat scaled{ QRDetector::upscaleForDecode(roi, scale) };
+        std::string content{ decodeQR(scaled) };
+        if (!content.empty()) {
+            worker.decodeCache.store(roi, qr.position, content, now);
+            roiOut = scaled;
+            return content;
+        }
+    }
+    return {};
+}
+
+void AppController::handleDecodedQR(const std::string& content, std::chrono::steady_clock::time_point scanned,
+                                    std::chrono::steady_clock::time_point visibleSince) {
+    // Resolved before stateMutex: the lookup takes mapMutex.
+    std::string roomName{ roomDisplayName(content) };
     std::string prevQR;
     {
         std::lock_guard<std::mutex> lock(stateMutex);
         prevQR = lastQRData;
         lastQRData = content;
-        if (auto resolved = mapSystem.resolveRoomId(content))
-            lastRoomName = mapSystem.getRooms().at(resolved.value()).m_name;
-        else
-            lastRoomName = content + " (unknown)";
+        lastRoomName = std::move(roomName);
     }
     if (content != prevQR) {
+        // Only the first instruction spoken for this code counts as its latency.
+        auto visibleAt{ visibleSince };
         if (currentInstructions.empty()) {
             handleNewQR(content);
         } else {
+            bool onRoute{ false };
             for (size_t i = 0; i < currentInstructions.size(); ++i) {
                 if (currentInstructions[i].text.find(content) != std::string::npos) {
+                    onRoute = true;
                     if (i + 1 < currentInstructions.size()) {
                         currentStepIndex = i+1;
                         currentSuggestion = currentInstructions[currentStepIndex].text;
@@ -156,18 +222,20 @@ void AppController::handleDecodedQR(const std::string& content) {
                         currentSuggestion = currentInstructions[i].text;
                         
                         std::lock_guard<std::mutex> qlock(ttsMutex);
-                        ttsQueue.push(TTSItem{currentSuggestion, TTSItem::Type::Nav});
+                        ttsQueue.push(TTSItem{currentSuggestion, TTSItem::Type::Nav, std::exchange(visibleAt, {})});
                         ttsCV.notify_one();
                     }
                     break;
                 }
             }
+            // Off the current route: re-plan from here (usually already speculated).
+            if (!onRoute) handleNewQR(content);
         }
 
         {
             std::lock_guard<std::mutex> lock(stateMutex);
             newQRScanned = true;
-            lastQRScanTime = std::chrono::steady_clock::now();
+            lastQRScanTime = scanned;
             lastQRData = content;
         }
 
@@ -175,18 +243,18 @@ void AppController::handleDecodedQR(const std::string& content) {
         ttsQueue.push(TTSItem{"QR detected: " + content, TTSItem::Type::Announce});
         ttsCV.notify_one();
         if (!lastInstruction.empty()) {
-            ttsQueue.push(TTSItem{lastInstruction, TTSItem::Type::Nav});
+            ttsQueue.push(TTSItem{lastInstruction, TTSItem::Type::Nav, std::exchange(visibleAt, {})});
             ttsCV.notify_one();
         } 
         else if (!currentInstructions.empty() && currentStepIndex == currentInstructions.size() - 1) {
             std::cout << currentSuggestion; 
-            ttsQueue.push(TTSItem{currentSuggestion, TTSItem::Type::Nav});
+            ttsQueue.push(TTSItem{currentSuggestion, TTSItem::Type::Nav, std::exchange(visibleAt, {})});
             ttsCV.notify_one();
         }
     }
 }
 
-void AppController::maybeAdvanceStep() {
+void AppController::maybeAdvanceStep(std::chrono::steady_clock::time_point now) {
     std::string nextText{};
     bool canAdvance{false};
     {
@@ -194,7 +262,6 @@ void AppController::maybeAdvanceStep() {
         if (newQRScanned && !currentInstructions.empty() &&
             currentStepIndex + 1 < currentInstructions.size() - 1) {
 
-            auto now = std::chrono::steady_clock::now();
             if (!navSpeaking && (now - lastQRScanTime >= std::chrono::seconds(3))) {
                 canAdvance = true;
                 nextText = currentInstructions[currentStepIndex + 1].text;
@@ -223,54 +290,119 @@ void AppController::setInstruction(const std::string& text) {
     lastInstruction = text;
 }
 
-void AppController::queueFrame(const cv::Mat& frame) {
-    std::lock_guard<std::mutex> lock(frameMutex);
-    if (frameQueue.size() > 2) frameQueue.pop();
-    frameQueue.push(frame.clone());
-    frameCV.notify_one();
-}
-
-void AppController::drawOverlay(cv::Mat& frame) {
+void AppController::drawOverlay(cv::Mat& view, const cv::Size& frameSize) {
+    // The box is in frame pixels; the view is the resized feed.
+    double sx{ static_cast<double>(view.cols) / frameSize.width };
+    double sy{ static_cast<double>(view.rows) / frameSize.height };
     std::lock_guard<std::mutex> lock(stateMutex);
     if (!lastInstruction.empty())
-        cv::putText(frame, lastInstruction, {10, 30},
-            cv::FONT_HERSHEY_SIMPLEX, 0.7, {0, 255, 0}, 2);
-    if (lastBBox.area() > 0)
-        cv::rectangle(frame, lastBBox, {0, 255, 0}, 2);
+        cv::putText(view, lastInstruction, {10, 30},
+            cv::FONT_HERSHEY_SIMPLEX, 0.6, {0, 255, 0}, 1);
+    if (lastBBox.area() > 0) {
+        cv::Rect box{ cvRound(lastBBox.x * sx), cvRound(lastBBox.y * sy),
+                      cvRound(lastBBox.width * sx), cvRound(lastBBox.height * sy) };
+        cv::rectangle(view, box, {0, 255, 0}, 2);
+    }
 }
 
-void AppController::showComposite(const cv::Mat& frame) {
-    cv::Mat hsv{}, mask{};
-    cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
-    mask = detector.makeColourMask(hsv, detector.getTargetColour());
-    cv::Mat qrPreview{};
+void AppController::showComposite(FrameContext& ctx) {
+    // The canvas is reused: the feed and mask are resized into it, the code
+    // preview is redrawn from the last decode and the text only when it changes.
+    // Frames that arrived without colour are shown in gray.
+    ui.setMainFeed(ctx.format() == FrameContext::PixelFormat::BGR ? ctx.bgr() : ctx.gray());
+    cv::Mat view{ ui.mainPanel() };
+    drawOverlay(view, ctx.size());
+    // The window's own copy of the frame, so the mask is built here, off the capture thread.
+    const QRDetector& detector{ cameras.front()->workers.front()->detector };
+    ui.setMask(detector.smallColourMask(ctx, detector.getTargetColour()));
     {
         std::lock_guard<std::mutex> lock(stateMutex);
-        qrPreview = lastQRROI.empty() ? cv::Mat(frame.size(), frame.type(), cv::Scalar(0,0,0)) : lastQRROI.clone();
-        qrPreview = lastQRROI.clone();
+        ui.setQRPreview(lastQRROI);
+        ui.setText(lastRoomName, destinationName, currentSuggestion);
     }
-
-    cv::Mat composite{ ui.makeComposite(frame, mask, qrPreview) };
-    cv::Mat finalDisplay{ ui.addTextPanel(composite, lastRoomName, destinationName, currentSuggestion) };
-    ui.showWindow(finalDisplay);
+    ui.showWindow();
 }
 
 bool AppController::checkForExitKey() {
+#ifdef NAVIGATION_HEADLESS
+    return false;
+#else
     char key{ static_cast<char>(cv::waitKey(1)) };
     if (key == 27) { 
         running = false;
-        frameCV.notify_all();
+        for (auto& camera : cameras) camera->ring.close();
         ttsCV.notify_all();
         return true;
     }
     return false;
+#endif
+}
+
+void AppController::setFrameSource(std::unique_ptr<FrameSource> source) {
+    cameras.front()->source = std::move(source);
+}
+
+void AppController::addCamera(std::unique_ptr<FrameSource> source) {
+    auto camera{ std::make_unique<Camera>() };
+    camera->index = cameras.size();
+    camera->source = std::move(source);
+    cameras.push_back(std::move(camera));
+}
+
+bool AppController::addAlertColour(const std::string& name) {
+    auto colour{ std::find_if(colourMap.begin(), colourMap.end(),
+        [&](const auto& c) { return c.first == name; }) };
+    if (colour == colourMap.end() || colour->second == QRColour::NONE) return false;
+    alertColours.push_back(colour->second);
+    return true;
+}
+
+void AppController::setLumaCapture(bool enabled) {
+    lumaCapture = enabled;
+}
+
+void AppController::setHeadless(bool enabled) {
+    headless = enabled;
+}
+
+void AppController::setDetectionWorkers(int workers) {
+    detectionWorkers = std::max(0, workers);
+}
+
+void AppController::setDetectionBudget(double msPerSecond) {
+    detectionBudgetMs = std::max(0.0, msPerSecond);
+}
+
+void AppController::setParallelVariants(int count) {
+    parallelVariants = std::max(1, count);
+}
+
+void AppController::addClosedConnection(const std::string& a, const std::string& b) {
+    closedConnections.emplace_back(a, b);
+}
+
+void AppController::setUiRate(double fps) {
+    uiInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(fps > 0.0 ? 1.0 / fps : 0.0));
 }
 
 AppController::AppController()
     : mapSystem("FICT Building", "Ground Floor")
+    , partitions(mapSystem)
     , ui("Navigation View", false)
     , currentStepIndex(0),
-    m_firstStepAfterQR(true) {
+    m_firstStepAfterQR(true)
+    , planner([this](const std::string& start, const std::string& goal) { return planRoute(start, goal); }) {
+
+    cameras.push_back(std::make_unique<Camera>());
+
+    // Loads and evictions change which routes exist; cached ones are re-planned.
+    // A loaded partition brings its connections back open, so closures are redone.
+    partitions.setMapMutex(&mapMutex);
+    partitions.setChangeCallback([this] {
+        applyClosedConnections(false);
+        planner.invalidate();
+    });
 
     reader.onMessage = [&](const std::string& msg) {
         return;
@@ -281,36 +413,100 @@ AppController::AppController()
     };
 }
 
-void AppController::handleNewQR(const std::string& content) {
+std::optional<std::string> AppController::resolveRoom(const std::string& ident) const {
+    std::lock_guard<std::mutex> lock(mapMutex);
+    if (partitions.isLoaded()) return partitions.resolveRoomId(ident);
+    return mapSystem.resolveRoomId(ident);
+}
+
+std::string AppController::roomDisplayName(const std::string& ident) const {
+    auto id{ resolveRoom(ident) };
+    std::optional<std::string> name{};
+    std::lock_guard<std::mutex> lock(mapMutex);
+    if (id) name = partitions.isLoaded() ? partitions.roomName(*id) : mapSystem.roomName(*id);
+    return name ? *name : ident + " (unknown)";
+}
+
+// Runs on the planner thread, the only one that changes the map after startup. It
+// reads without mapMutex (A*, instruction rendering, partition file reads) and the
+// partition manager takes it only while merging or evicting; other threads read
+// under it.
+PlannedRoute AppController::planRoute(const std::string& start, const std::string& goal) {
+    ScopedLatency timer{ LatencyStage::RoutePlan };
+    // Partitioned maps only hold some buildings/floors; load the ones this route
+    // needs. A* itself runs once, in pathToInstructions. When loading failed it
+    // finds no path quickly (unknown room or different components) and says so.
+    if (partitions.isLoaded()) partitions.prepareRoute(start, goal);
+
     auto [instrs, summary] {
         guider.pathToInstructions(
             mapSystem,
-            content,
-            destinationId,
+            start,
+            goal,
             unitScale,
             stepLengthM,
             "steps",
             20.0,
             true
         )};
-    routeReset = true;
-    std::lock_guard<std::mutex> lock(stateMutex);
-    lastQRData = content;
+    PlannedRoute route{};
+    route.instructions = std::move(instrs);
+    route.summary = std::move(summary);
+    return route;
+}
+
+std::vector<std::string> AppController::adjacentAnchors(const std::string& roomId) const {
+    std::lock_guard<std::mutex> lock(mapMutex);
+    auto id{ partitions.isLoaded() ? partitions.resolveRoomId(roomId) : mapSystem.resolveRoomId(roomId) };
+    if (!id) return {};
+    return mapSystem.getNeighbours(*id);
+}
+
+void AppController::handleNewQR(const std::string& content) {
+    pendingRoute = planner.plan(content);
+    // A speculative hit is applied straight away; otherwise the detection loop
+    // picks the route up once the planner finishes.
+    applyPendingRoute();
+}
 
-    if (auto resolvedStart = mapSystem.resolveRoomId(content))
-        lastRoomName = mapSystem.getRooms().at(resolvedStart.value()).m_name;
-    else lastRoomName = content + " (unknown)";
+void AppController::applyPendingRoute() {
+    if (!pendingRoute.valid()) return;
+    if (pendingRoute.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
 
-    currentInstructions = instrs;
-    currentStepIndex = 0;
-    lastStepTime = std::chrono::steady_clock::now();
-    currentSuggestion = currentInstructions.empty() ? std::string("No path found.") : currentInstructions[0].text;
-    m_firstStepAfterQR = true;
+    PlannedRoute route{};
+    try {
+        route = pendingRoute.get();
+    } catch (const std::exception& e) {
+        std::cerr << "Route planning failed: " << e.what() << "\n";
+        pendingRoute = {};
+        return;
+    }
+    pendingRoute = {};
+    if (route.cancelled) return;
+
+    const std::string& content{ route.startRoom };
+    std::string roomName{ roomDisplayName(content) };
+    routeReset = true;
     {
-        std::lock_guard<std::mutex> slock(speechMutex);
-        lastSpeechEndTime = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(stateMutex);
+        lastQRData = content;
+
+        lastRoomName = std::move(roomName);
+
+        currentInstructions = route.instructions;
+        currentStepIndex = 0;
+        lastStepTime = std::chrono::steady_clock::now();
+        currentSuggestion = currentInstructions.empty() ? std::string("No path found.") : currentInstructions[0].text;
+        m_firstStepAfterQR = true;
+        {
+            std::lock_guard<std::mutex> slock(speechMutex);
+            lastSpeechEndTime = std::chrono::steady_clock::now();
+        }
+        navSpeaking = false;
     }
-    navSpeaking = false;
+
+    // The next scan is most likely one of the neighbouring anchors.
+    planner.speculate(adjacentAnchors(content));
 }
 
 void AppController::ttsWorker(TextToSpeech& tts) {
@@ -322,7 +518,14 @@ void AppController::ttsWorker(TextToSpeech& tts) {
         ttsQueue.pop();
         lock.unlock();
 
-        tts.speak(item.text);
+        if (item.visibleAt != std::chrono::steady_clock::time_point{}) {
+            std::chrono::duration<double, std::milli> latency{ std::chrono::steady_clock::now() - item.visibleAt };
+            latencyHistogram(LatencyStage::EndToEnd).record(latency.count());
+        }
+        {
+            ScopedLatency timer{ LatencyStage::Speech };
+            tts.speak(item.text);
+        }
         if (item.type == TTSItem::Type::Nav) {
             std::lock_guard<std::mutex> slock(speechMutex);
             lastSpeechEndTime = std::chrono::steady_clock::now();
@@ -331,76 +534,235 @@ void AppController::ttsWorker(TextToSpeech& tts) {
     }
 }
 
-void AppController::detectionWorker(QRDetector& detector, QRReader& reader, RouteGuidance& guider) {
+void AppController::captureWorker(Camera& camera) {
+    // Only the first camera is on screen. The window gets its own copy at the UI
+    // rate, so drawing never holds up capture and never takes a frame from detection.
+    bool feedsUi{ camera.index == 0 && !headless };
+    while (running && !stopRequested) {
+        FrameContext& ctx{ camera.ring.writeSlot() };
+        {
+            ScopedLatency timer{ LatencyStage::Capture };
+            if (!camera.source->readInto(ctx) || ctx.empty()) break;
+        }
+        camera.ring.publish();
+
+        auto now{ std::chrono::steady_clock::now() };
+        if (!feedsUi || now - lastUiRender < uiInterval) continue;
+        lastUiRender = now;
+        uiRing.writeSlot().copyFrom(ctx);
+        uiRing.publish();
+    }
+    // This camera's detection threads stop; the others carry on. The first
+    // camera stopping ends the run (see run()).
+    camera.ring.close();
+    if (camera.index == 0) uiRing.close();
+}
+
+void AppController::detectionWorker(Camera& camera, std::size_t worker) {
     while (running) {
-        cv::Mat frame{ waitForNextFrame() };
-        if (frame.empty()) break;
-        if (!detector.shouldAttemptDetection()) continue;
+        auto ctx{ waitForNextFrame(camera.ring, static_cast<int>(worker)) };
+        if (!ctx || ctx->empty()) break;
+        {
+            std::lock_guard<std::mutex> lock(fusionMutex);
+            applyPendingRoute();
+        }
+        processFrame(camera, *camera.workers[worker], *ctx);
+    }
+}
 
-        cv::Mat hsv{};
-        cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+AppController::FrameResult AppController::processFrame(Camera& camera, Worker& worker, FrameContext& ctx) {
+    FrameResult result{};
+    auto now{ ctx.captureTime() };
+    QRDetector& detector{ worker.detector };
+    QRTracker& tracker{ camera.tracker };
+    DetectionScheduler& scheduler{ camera.scheduler };
+    // Pool workers see every n-th frame, so they detect each one in full
+    // instead of tracking from a previous frame.
+    bool pooled{ detectionWorkers > 0 };
+
+    // Between detections the tracker moves the last code every frame. A full
+    // detection runs when it loses confidence (straight away) or, with no
+    // track, whenever the scheduler allows.
+    bool wasTracking{ !pooled && tracker.isTracking() };
+    bool detected{ false };
+    std::string alertContent{};
+    std::optional<QRCode> nearest{};
+    if (wasTracking) nearest = tracker.update(ctx.gray(), now);
+    if (nearest) result.stage = FrameResult::Stage::Tracked;
+
+    if (!nearest || (!pooled && tracker.needsRedetect())) {
+        if (!pooled && !wasTracking && !scheduler.shouldDetect(ctx)) return result;
+
+        auto started{ std::chrono::steady_clock::now() };
+        auto codes = detector.detectQRCodes(ctx, false);
+        // Codes in an alert colour are read out below, not followed.
+        auto alerts{ std::stable_partition(codes.begin(), codes.end(),
+            [&detector](const QRCode& qr) { return qr.colour == detector.getTargetColour(); }) };
+        if (auto alert{ detector.findNearestQRCode(std::vector<QRCode>(alerts, codes.end())) }) {
+            cv::Mat alertRoi{};
+            alertContent = decodeMultiScale(worker, *alert, ctx, alertRoi);
+        }
+        codes.erase(alerts, codes.end());
+        nearest = detector.findNearestQRCode(codes);
+        if (!pooled) scheduler.record(now, elapsedMs(started), nearest.has_value());
+        detected = true;
+        result.stage = FrameResult::Stage::Detected;
+        result.codes = codes.size();
+        if (!pooled) {
+            if (nearest) tracker.reset(*nearest, ctx.gray(), now);
+            else tracker.clear();
+        }
+    }
+    result.nearest = nearest;
+
+    // Decode attempts on tracked frames keep the detection gap and budget,
+    // without counting as a detection. A code already decoded on this track
+    // isn't read again.
+    bool attempted{ false };
+    cv::Mat roi{};
+    if (nearest && nearest->content.empty() && (detected || scheduler.mayDecode(now))) {
+        attempted = true;
+        auto started{ std::chrono::steady_clock::now() };
+        result.decoded = decodeMultiScale(worker, *nearest, ctx, roi);
+        if (!pooled) scheduler.record(now, elapsedMs(started), true);
+        if (!result.decoded.empty()) {
+            if (!pooled) tracker.setContent(result.decoded);
+            nearest->content = result.decoded;
+        }
+    }
 
-        cv::Mat mask{ detector.makeColourMask(hsv, detector.getTargetColour()) };
-        cv::Mat maskedFrame{};
-        cv::bitwise_and(frame, frame, maskedFrame, mask);
+    std::lock_guard<std::mutex> fusionLock(fusionMutex);
+    // Results reach navigation in frame order: one that finishes after a
+    // newer frame's (a slower worker's) is out of date and dropped.
+    if (now <= camera.lastDelivered) {
+        ++camera.staleResults;
+        return result;
+    }
+    camera.lastDelivered = now;
+    if (!alertContent.empty()) {
+        bool announce{ alertContent != lastAlert || now - lastAlertSeen > ALERT_FORGET_AFTER };
+        lastAlert = alertContent;
+        lastAlertSeen = now;
+        if (announce) {
+            std::lock_guard<std::mutex> lock(ttsMutex);
+            ttsQueue.push(TTSItem{"Alert code: " + alertContent, TTSItem::Type::Announce});
+            ttsCV.notify_one();
+        }
+    }
+    if (!nearest) camera.codeVisibleSince.reset();
+    else if (!camera.codeVisibleSince) camera.codeVisibleSince = now;
+
+    // Only the camera with the best view drives guidance and decoding.
+    std::optional<QRObservation> seen{};
+    if (nearest) seen = QRObservation{ camera.index, *nearest, detected ? 1.0f : tracker.confidence(), now };
+    auto best{ fusion.update(camera.index, seen, now) };
+    if (!best) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        lastInstruction.clear();
+        lastBBox = {};
+        return result;
+    }
+    if (best->camera != camera.index) return result;
 
-        auto codes = detector.detectQRCodes(frame, false);
-        auto nearest = detector.findNearestQRCode(codes);
+    updateGuidanceOverlay(camera, *nearest, ctx.size());
 
-        if (!nearest) {
+    if (!result.decoded.empty()) {
+        {
             std::lock_guard<std::mutex> lock(stateMutex);
-            lastInstruction.clear();
-            lastBBox = {};
-            continue;
+            lastQRROI = roi.clone();
         }
+        handleDecodedQR(result.decoded, now, camera.codeVisibleSince.value_or(now));
+        return result;
+    }
+    if (attempted) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        lastQRROI.release();
+    }
 
-        updateGuidanceOverlay(*nearest, frame.size());
-
-        if(!isCloseEnough(*nearest)) {
-            setInstruction("Move closer to the QR");
+    // Already decoded on this track; handleDecodedQR would ignore it anyway.
+    if (!nearest->content.empty()) return result;
+    // The code is read from wherever it is before the user is asked to walk over.
+    if(!isCloseEnough(*nearest, camera.captureScale)) {
+        setInstruction("Move closer to the QR");
 
-            auto now{ std::chrono::steady_clock::now() };
-            if (std::chrono::duration_cast<std::chrono::seconds>(now - lastDistanceTTS).count() >= 2){
-                {
-                    std::lock_guard<std::mutex> lock(ttsMutex);
-                    ttsQueue.push(TTSItem{"Please move closer to the QR code", TTSItem::Type::Announce});
-                    ttsCV.notify_one();
-                }
-                lastDistanceTTS = now;
+        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastDistanceTTS).count() >= 2){
+            {
+                std::lock_guard<std::mutex> lock(ttsMutex);
+                ttsQueue.push(TTSItem{"Please move closer to the QR code", TTSItem::Type::Announce});
+                ttsCV.notify_one();
             }
-            continue;
+            lastDistanceTTS = now;
         }
+    }
+    return result;
+}
 
-        if (nearest->bbox.width >= QR_DECODE_MIN_WIDTH) {
-            auto roi{ extractQRROI(*nearest, frame) };
-            auto content{ decodeQR(roi) };
+bool AppController::loadMap() {
+#ifdef NAVIGATION_EMBEDDED_MAP
+    mapSystem.useStaticMap(EmbeddedMap::EMBEDDED_MAP);
+#else
+    if (partitions.loadManifest("utils/partitions.txt")) {
+        std::cout << "Using partitioned map (" << partitions.residentBytes() << " bytes resident)\n";
+    } else if (!mapSystem.loadRoomsFromFile("utils/rooms.txt") ||
+        !mapSystem.loadConnectionsFromFile("utils/connections.txt")) {
+        std::cerr << "Failed to load map data\n";
+        return false;
+    }
+#endif
+    applyClosedConnections(true);
+    return true;
+}
 
-            if (!content.empty()) {
-                {
-                    std::lock_guard<std::mutex> lock(stateMutex);
-                    lastQRROI = roi.clone(); 
-                }
-                handleDecodedQR(content);
-            } else {
-                std::lock_guard<std::mutex> lock(stateMutex);
-                lastQRROI.release(); 
-            }
-        }
+// Map writes happen on the loading thread or the planner thread; see planRoute.
+void AppController::applyClosedConnections(bool warn) {
+    if (closedConnections.empty()) return;
+    std::lock_guard<std::mutex> lock(mapMutex);
+    if (warn && mapSystem.isStaticMap()) {
+        std::cerr << "Closed connections are ignored with the embedded map\n";
+        return;
+    }
+    for (const auto& [a, b] : closedConnections) {
+        mapSystem.setConnectionAccessible(a, b, false);
+        // Partition connections only exist once their partition is loaded.
+        if (warn && !partitions.isLoaded() && !mapSystem.getConnection(a, b))
+            std::cerr << "Closed connection " << a << "|" << b << " is not on the map\n";
+    }
+}
 
+void AppController::configureCamera(Camera& camera, QRColour targetColour) {
+    // Without a target colour nothing but luminance is needed.
+    camera.source->setLumaOnly(targetColour == QRColour::NONE);
+
+    // One ring consumer per detection thread.
+    int workers{ std::max(1, detectionWorkers) };
+    camera.ring.setConsumers(workers);
+    camera.workers.clear();
+    for (int i{ 0 }; i < workers; ++i) camera.workers.push_back(std::make_unique<Worker>());
+
+    // Detector sizes are tuned for full-resolution frames.
+    float captureScale{ static_cast<float>(camera.source->downscale()) };
+    camera.captureScale = captureScale;
+    // Alert colours ride along in the same pass; without a route colour every
+    // code is followed anyway.
+    std::vector<QRColour> colours{ targetColour };
+    colours.insert(colours.end(), alertColours.begin(), alertColours.end());
+    for (auto& worker : camera.workers) {
+        QRDetector& detector{ worker->detector };
+        detector.setTargetColours(colours);
+        detector.setMinArea(static_cast<int>(1000 / (captureScale * captureScale)));
+        detector.setAspectRatioTolerance(0.8f, 1.25f);
+        detector.setBoundingBoxPadding(static_cast<int>(150 / captureScale));
+        detector.setDistanceReference(120.0f / captureScale, 1.0f);
+        detector.setColourVerificationEnabled(true);
+        detector.setParallelVariants(parallelVariants);
     }
+    camera.scheduler.setCpuBudget(detectionBudgetMs.value_or(DEFAULT_DETECTION_BUDGET_MS));
 }
 
 void AppController::run() {
-    std::vector<std::pair<std::string, QRColour>> colourMap{
-        {"red", QRColour::RED},
-        { "green", QRColour::GREEN },
-        { "blue", QRColour::BLUE },
-        { "none", QRColour::NONE }
-    };
     int colourChoice{};
 
     std::thread ttsThread(&AppController::ttsWorker, this, std::ref(tts));
-    std::thread detectThread(&AppController::detectionWorker, this, std::ref(detector), std::ref(reader), std::ref(guider));
 
     {
         std::lock_guard<std::mutex> lock(ttsMutex);
@@ -448,11 +810,7 @@ void AppController::run() {
         ttsCV.notify_one();
     }
 
-    if (!mapSystem.loadRoomsFromFile("utils/rooms.txt") ||
-        !mapSystem.loadConnectionsFromFile("utils/connections.txt")) {
-        std::cerr << "Failed to load map data\n";
-        return;
-    }
+    if (!loadMap()) return;
 
     while(true){
         {
@@ -473,10 +831,10 @@ void AppController::run() {
                 return std::toupper(c);
             });
         
-        auto resolvedDest{ mapSystem.resolveRoomId(destinationId) };
+        auto resolvedDest{ resolveRoom(destinationId) };
         if (resolvedDest) {
             destinationId = resolvedDest.value();
-            destinationName = mapSystem.getRooms().at(destinationId).m_name;
+            destinationName = roomDisplayName(destinationId);
             break;
         } else {
             {
@@ -491,47 +849,373 @@ void AppController::run() {
         ttsQueue.push(TTSItem{"You chose destination "+ destinationId, TTSItem::Type::Announce});
         ttsCV.notify_one();
     }
-
-    detector.setTargetColour(targetColour);
-    detector.setMinArea(1000);
-    detector.setAspectRatioTolerance(0.8f, 1.25f);
-    detector.setBoundingBoxPadding(150);
-    detector.setDistanceReference(120.0f, 1.0f);
-    detector.setColourVerificationEnabled(true);
-    detector.setDetectionThrottle(2,1000);
-
-    // If you're on linux
-    std::string pipeline =
-    "v4l2src device=/dev/video0 ! "
-    "image/jpeg, width=1280, height=720, framerate=30/1 ! "
-    "jpegdec ! videoconvert ! appsink";
-
-    cv::VideoCapture cap(pipeline, cv::CAP_GSTREAMER);
-
-    // If you're not on linux
-    // cv::VideoCapture cap(0);
-    if (!cap.isOpened()) {
-        std::cerr << "Failed to open camera\n";
+    planner.setDestination(destinationId);
+
+    Camera& primary{ *cameras.front() };
+    std::unique_ptr<FrameSource>& frameSource{ primary.source };
+    if (!frameSource && lumaCapture) {
+        // Raw YUV keeps the Y plane as captured; colour is converted only where used
+        std::string pipeline =
+        "v4l2src device=/dev/video0 ! "
+        "video/x-raw, format=YUY2, width=1280, height=720, framerate=30/1 ! "
+        "appsink";
+        frameSource = std::make_unique<YuvCaptureSource>(pipeline);
+    }
+    if (!frameSource) {
+#ifdef NAVIGATION_HAVE_LIBJPEG
+        // If you're on linux: keep the camera's JPEGs and decode them at half size
+        std::string pipeline =
+        "v4l2src device=/dev/video0 ! "
+        "image/jpeg, width=1280, height=720, framerate=30/1 ! "
+        "appsink";
+        frameSource = MjpegSource::fromPipeline(pipeline, 2);
+#else
+        // If you're on linux
+        std::string pipeline =
+        "v4l2src device=/dev/video0 ! "
+        "image/jpeg, width=1280, height=720, framerate=30/1 ! "
+        "jpegdec ! videoconvert ! appsink";
+        frameSource = std::make_unique<VideoCaptureSource>(pipeline, cv::CAP_GSTREAMER);
+#endif
+        // If you're not on linux
+        // frameSource = std::make_unique<VideoCaptureSource>(0);
+    }
+    for (auto& camera : cameras) {
+        if (camera->source && camera->source->isOpened()) continue;
+        std::cerr << "Failed to open camera " << camera->index << "\n";
         return;
     }
 
-    cv::Mat frame{};
+#ifdef NAVIGATION_HEADLESS
+    headless = true;  // built without highgui
+#endif
+    for (auto& camera : cameras) configureCamera(*camera, targetColour);
+
+    // Ctrl+C / a service manager stops the loop the same way Esc does.
+    stopRequested = 0;
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+
+    // Detection threads per camera (one, or the pool) and a capture thread per
+    // camera; this thread only draws the window and paces guidance.
+    std::vector<std::thread> detectThreads{};
+    std::vector<std::thread> captureThreads{};
+    for (auto& camera : cameras) {
+        for (std::size_t w{ 0 }; w < camera->workers.size(); ++w)
+            detectThreads.emplace_back(&AppController::detectionWorker, this, std::ref(*camera), w);
+        captureThreads.emplace_back(&AppController::captureWorker, this, std::ref(*camera));
+    }
 
     std::string lastSpokenSuggestion{};
 
     if (routeReset) { lastSpokenSuggestion.clear(); routeReset = false; }
 
-    while (true){
-        if (!cap.read(frame) || frame.empty()) break;
-        queueFrame(frame);
-        drawOverlay(frame);
-        maybeAdvanceStep();
-        showComposite(frame);
+    while (!stopRequested && running){
+        // Without a display there is nothing to wait on but the first camera.
+        if (headless) {
+            if (primary.ring.closed()) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        FrameContext* ctx{ headless ? nullptr : uiRing.acquire() };
+        if (!headless && !ctx) break;  // the first camera stopped
+
+        maybeAdvanceStep(std::chrono::steady_clock::now());
+        dumpLatency(false);
+        if (headless) continue;
 
-        if(checkForExitKey()) break;
+        showComposite(*ctx);
+        if (checkForExitKey()) break;
     }
 
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+
+    // End of a recording, a camera error or a stop signal stops the workers too.
+    running = false;
+    for (auto& camera : cameras) camera->ring.close();
+    uiRing.close();
+    ttsCV.notify_all();
+
     // Join threads
-    detectThread.join();
+    for (auto& t : captureThreads) t.join();
+    for (auto& t : detectThreads) t.join();
     ttsThread.join();
+
+    for (auto& camera : cameras) {
+        auto ringStats{ camera->ring.getStats() };
+        if (cameras.size() > 1) std::cout << "[camera " << camera->index << "] ";
+        std::cout << "Frames: " << ringStats.published << " captured, " << ringStats.consumed << " detected, "
+                  << ringStats.dropped << " dropped; capture-to-detect " << ringStats.meanLatencyMs
+                  << " ms mean, " << ringStats.maxLatencyMs << " ms max\n";
+    }
+
+    printStats();
+    dumpLatency(true);
+}
+
+void AppController::printStats() {
+    for (auto& camera : cameras) {
+        std::string prefix{ cameras.size() > 1 ? "[camera " + std::to_string(camera->index) + "] " : "" };
+
+        // Summed over the camera's workers.
+        std::vector<QRDetector::VariantStat> variantStats(QRDetector::VARIANT_COUNT);
+        QRDetector::RoiSearchStats roiStats{};
+        DecodeCache::Stats cacheStats{};
+        QRDetector::CandidateStats candidateStats{};
+        for (const auto& worker : camera->workers) {
+            auto variants{ worker->detector.getVariantStats() };
+            for (int v{ 0 }; v < QRDetector::VARIANT_COUNT; ++v) {
+                variantStats[v].attempts += variants[v].attempts;
+                variantStats[v].hits += variants[v].hits;
+            }
+            auto roi{ worker->detector.getRoiSearchStats() };
+            roiStats.fastAttempts += roi.fastAttempts;
+            roiStats.fastHits += roi.fastHits;
+            roiStats.fullSearches += roi.fullSearches;
+            roiStats.savedMs += roi.savedMs;
+            auto candidates{ worker->detector.getCandidateStats() };
+            candidateStats.frames += candidates.frames;
+            candidateStats.components += candidates.components;
+            candidateStats.cascades += candidates.cascades;
+            auto cache{ worker->decodeCache.getStats() };
+            cacheStats.lookups += cache.lookups;
+            cacheStats.hits += cache.hits;
+            cacheStats.expired += cache.expired;
+        }
+
+        for (int v{ 0 }; v < QRDetector::VARIANT_COUNT; ++v) {
+            const auto& st{ variantStats[v] };
+            std::cout << prefix << "Variant " << QRDetector::variantName(static_cast<QRDetector::Variant>(v))
+                      << ": " << st.hits << "/" << st.attempts << " hits\n";
+        }
+
+        double hitRate{ roiStats.fastAttempts ? 100.0 * roiStats.fastHits / roiStats.fastAttempts : 0.0 };
+        std::size_t detections{ roiStats.fastHits + roiStats.fullSearches };
+        std::cout << prefix << "Predicted ROI: " << roiStats.fastHits << "/" << roiStats.fastAttempts << " hits ("
+                  << hitRate << "%), " << roiStats.fullSearches << " full searches, ~"
+                  << (detections ? roiStats.savedMs / detections : 0.0) << " ms saved per detection\n";
+
+        if (candidateStats.frames) {
+            std::size_t saved{ candidateStats.components - candidateStats.cascades };
+            std::cout << prefix << "Candidates: " << candidateStats.cascades << "/" << candidateStats.components
+                      << " sent to the detector, " << saved << " skipped ("
+                      << static_cast<double>(saved) / candidateStats.frames << " per detection)\n";
+        }
+
+        std::cout << prefix << "Decode cache: " << cacheStats.hits << "/" << cacheStats.lookups << " hits, "
+                  << cacheStats.expired << " expired\n";
+
+        if (std::size_t corrupt{ camera->source ? camera->source->corruptFrames() : 0 })
+            std::cout << prefix << "Source: " << corrupt << " corrupt frames skipped\n";
+
+        auto schedStats{ camera->scheduler.getStats() };
+        if (schedStats.frames) {
+            std::cout << prefix << "Scheduler: " << schedStats.detections << "/" << schedStats.frames << " frames allowed ("
+                      << schedStats.sceneChanges << " on scene change), " << schedStats.waited << " static, "
+                      << schedStats.overBudget << " over budget, " << schedStats.busyMs << " ms busy\n";
+        }
+
+        if (camera->workers.size() > 1)
+            std::cout << prefix << "Detection workers: " << camera->workers.size() << ", "
+                      << camera->staleResults << " out-of-order results dropped\n";
+    }
+
+    if (cameras.size() > 1) {
+        auto fusionStats{ fusion.getStats() };
+        std::cout << "Fusion:";
+        for (std::size_t c{ 0 }; c < fusionStats.picks.size(); ++c)
+            std::cout << " camera " << c << " chosen " << fusionStats.picks[c] << "x;";
+        std::cout << " " << fusionStats.handovers << " handovers\n";
+    }
+
+    writeLatencyReport(std::cout);
+}
+
+void AppController::setLatencyLog(const std::string& path, std::chrono::seconds interval) {
+    latencyLogPath = path;
+    latencyDumpInterval = interval;
+}
+
+void AppController::dumpLatency(bool force) {
+    if (latencyLogPath.empty()) return;
+    auto now{ std::chrono::steady_clock::now() };
+    if (!force && now - lastLatencyDump < latencyDumpInterval) return;
+    lastLatencyDump = now;
+
+    // Rewritten each time; histograms cover the whole run so far.
+    std::ofstream out(latencyLogPath, std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to write " << latencyLogPath << "\n";
+        latencyLogPath.clear();
+        return;
+    }
+    writeLatencyReport(out);
+}
+
+bool AppController::replay(const ReplayOptions& options) {
+    auto colour{ std::find_if(colourMap.begin(), colourMap.end(),
+        [&](const auto& c) { return c.first == options.colour; }) };
+    if (colour == colourMap.end()) {
+        std::cerr << "Unknown colour: " << options.colour << "\n";
+        return false;
+    }
+    if (!loadMap()) return false;
+
+    destinationId = options.destination;
+    toUpperInPlace(destinationId);
+    auto resolvedDest{ resolveRoom(destinationId) };
+    if (!resolvedDest) {
+        std::cerr << "Destination not found: " << options.destination << "\n";
+        return false;
+    }
+    destinationId = *resolvedDest;
+    destinationName = roomDisplayName(destinationId);
+    planner.setDestination(destinationId);
+
+    // A replay is one recording, so one camera.
+    Camera& camera{ *cameras.front() };
+    std::unique_ptr<FrameSource>& frameSource{ camera.source };
+    if (!frameSource || !frameSource->isOpened()) {
+        std::cerr << "Failed to open replay input\n";
+        return false;
+    }
+    configureCamera(camera, colour->second);
+    // The budget charges measured processing time, so the same recording could skip
+    // different frames from run to run. Replays only use it when asked for.
+    if (!detectionBudgetMs) camera.scheduler.setCpuBudget(0.0);
+
+    std::vector<double> timestampsMs{};
+    if (!options.timestampsPath.empty()) {
+        std::ifstream in(options.timestampsPath);
+        if (!in) {
+            std::cerr << "Failed to open " << options.timestampsPath << "\n";
+            return false;
+        }
+        for (double ms{}; in >> ms;) timestampsMs.push_back(ms);
+    }
+    double fps{ options.fps > 0.0 ? options.fps : frameSource->frameRate() };
+    if (fps <= 0.0) fps = 30.0;
+
+    bool pooled{ detectionWorkers > 0 };
+    std::ofstream log{};
+    if (!options.logPath.empty() && pooled) {
+        std::cerr << "--log is ignored with detection workers\n";
+    } else if (!options.logPath.empty()) {
+        log.open(options.logPath);
+        if (!log) {
+            std::cerr << "Failed to open " << options.logPath << "\n";
+            return false;
+        }
+        log << "frame\tt_ms\tstage\tcodes\tbbox\tdistance\tdecoded\tguidance\tspoken\n";
+        log << std::fixed << std::setprecision(2);
+    }
+
+    // Every time the pipeline looks at is relative to the start of the replay.
+    const auto start{ std::chrono::steady_clock::now() };
+    camera.scheduler.restart(start);
+    lastDistanceTTS = start - std::chrono::seconds(2);
+
+    std::size_t frames{ 0 };
+    double lastMs{ 0.0 };
+    std::chrono::steady_clock::time_point captured{};
+    // Reads the next frame and stamps it with its replay time.
+    auto readFrame{ [&](FrameContext& ctx) {
+        {
+            ScopedLatency timer{ LatencyStage::Capture };
+            if (!frameSource->readInto(ctx) || ctx.empty()) return false;
+        }
+        if (!timestampsMs.empty() && frames >= timestampsMs.size()) {
+            std::cerr << "Timestamps ran out after " << frames << " frames\n";
+            return false;
+        }
+        lastMs = timestampsMs.empty() ? frames * 1000.0 / fps : timestampsMs[frames];
+        captured = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(lastMs));
+        ctx.commit(ctx.format(), captured);
+        if (options.realTime) std::this_thread::sleep_until(captured);
+        return true;
+    } };
+    // Speech is taken as finished as soon as it is queued.
+    auto drainSpeech{ [&] {
+        std::vector<std::string> spoken{};
+        std::lock_guard<std::mutex> lock(ttsMutex);
+        while (!ttsQueue.empty()) {
+            const TTSItem& item{ ttsQueue.front() };
+            if (item.visibleAt != std::chrono::steady_clock::time_point{}) {
+                std::chrono::duration<double, std::milli> latency{ captured - item.visibleAt };
+                latencyHistogram(LatencyStage::EndToEnd).record(latency.count());
+            }
+            if (item.type == TTSItem::Type::Nav) {
+                std::lock_guard<std::mutex> slock(speechMutex);
+                lastSpeechEndTime = captured;
+                navSpeaking = false;
+            }
+            spoken.push_back(std::move(ttsQueue.front().text));
+            ttsQueue.pop();
+        }
+        return spoken;
+    } };
+
+    int64_t ticks{ cv::getTickCount() };
+    if (pooled) {
+        // The pool takes every frame: the next one is read while the last is
+        // detected and published only once a worker has picked that one up.
+        std::vector<std::thread> workers{};
+        for (std::size_t w{ 0 }; w < camera.workers.size(); ++w)
+            workers.emplace_back(&AppController::detectionWorker, this, std::ref(camera), w);
+        while (readFrame(camera.ring.writeSlot())) {
+            camera.ring.waitUntilTaken();
+            camera.ring.publish();
+            maybeAdvanceStep(captured);
+            drainSpeech();
+            ++frames;
+            dumpLatency(false);
+        }
+        camera.ring.waitUntilTaken();
+        camera.ring.close();
+        for (auto& t : workers) t.join();
+        drainSpeech();
+    }
+
+    FrameContext ctx{};
+    while (!pooled && readFrame(ctx)) {
+        FrameResult result{ processFrame(camera, *camera.workers.front(), ctx) };
+        // Routes are waited for so they land on the same frame every run.
+        if (pendingRoute.valid()) pendingRoute.wait();
+        applyPendingRoute();
+        maybeAdvanceStep(captured);
+        std::vector<std::string> spoken{ drainSpeech() };
+
+        if (log.is_open()) {
+            static const char* stageNames[]{ "skip", "track", "detect" };
+            log << frames << "\t" << lastMs << "\t" << stageNames[static_cast<int>(result.stage)] << "\t" << result.codes << "\t";
+            if (result.nearest) {
+                const cv::Rect& b{ result.nearest->bbox };
+                log << b.x << "," << b.y << "," << b.width << "," << b.height << "\t" << result.nearest->distance;
+            } else {
+                log << "-\t-";
+            }
+            log << "\t" << (result.decoded.empty() ? "-" : result.decoded) << "\t";
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                log << (lastInstruction.empty() ? "-" : lastInstruction);
+            }
+            log << "\t";
+            for (std::size_t i{ 0 }; i < spoken.size(); ++i) log << (i ? " | " : "") << spoken[i];
+            if (spoken.empty()) log << "-";
+            log << "\n";
+        }
+        ++frames;
+        dumpLatency(false);
+    }
+
+    double elapsedMs{ (cv::getTickCount() - ticks) * 1000.0 / cv::getTickFrequency() };
+    double mediaMs{ frames ? lastMs + 1000.0 / fps : 0.0 };
+    std::cout << "Replay: " << frames << " frames in " << elapsedMs << " ms ("
+              << (elapsedMs > 0.0 ? frames * 1000.0 / elapsedMs : 0.0) << " fps, "
+              << (elapsedMs > 0.0 ? mediaMs / elapsedMs : 0.0) << "x real time, "
+              << camera.workers.size() << (pooled ? " pooled" : "") << " detection worker(s))\n";
+    printStats();
+    dumpLatency(true);
+    return true;
 }
@@ -2,47 +2,175 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <optional>
+#include <memory>
+#include <mutex>
+#include "../modules/FrameContext.h"
+#include "../modules/FrameSource.h"
+#include "../modules/FrameRing.h"
 #include "../modules/QRDetector.h"
 #include "../modules/QRReader.h"
+#include "../modules/QRTracker.h"
+#include "../modules/DecodeCache.h"
+#include "../modules/DetectionScheduler.h"
+#include "../modules/ObservationFusion.h"
+#include "../modules/LatencyHistogram.h"
 #include "../modules/CoordinateMapSystem.h"
+#include "../modules/MapPartitionManager.h"
 #include "../modules/RouteGuidance.h"
+#include "../modules/RoutePlanner.h"
 #include "../modules/TextToSpeech.h"
 #include "UIManager.h"
 
 namespace NavigationVI{
     class AppController{
     public:
+        // What the detection step did with one frame.
+        struct FrameResult{
+            enum class Stage{ Skipped, Tracked, Detected } stage{ Stage::Skipped };
+            std::size_t codes{ 0 };  // found by a full detection
+            std::optional<QRCode> nearest{};
+            std::string decoded{};  // read on this frame
+        };
+
+        // Headless replay of a recording; see replay().
+        struct ReplayOptions{
+            std::string colour{ "none" };
+            std::string destination{};
+            std::string logPath{};  // per-frame log; empty for none
+            std::string timestampsPath{};  // one capture time in ms per line
+            double fps{ 0.0 };  // without timestamps; 0 uses the source's rate, else 30
+            bool realTime{ false };  // pace frames at their timestamps
+        };
+
+        // What one detection thread owns.
+        struct Worker{
+            QRDetector detector{};
+            DecodeCache decodeCache{};
+        };
+
+        // One camera: its source, frame ring and detection state. Every camera
+        // has its own detection threads, and all but the first (which the
+        // window shows) their own capture thread, so a camera that stalls
+        // holds up nobody else.
+        struct Camera{
+            std::size_t index{ 0 };
+            std::unique_ptr<FrameSource> source{};
+            FrameRing ring{};
+            std::vector<std::unique_ptr<Worker>> workers{};  // one per detection thread
+            QRTracker tracker{};  // single-worker mode only
+            DetectionScheduler scheduler{};  // single-worker mode only
+            std::optional<std::chrono::steady_clock::time_point> codeVisibleSince{};  // under fusionMutex
+            std::chrono::steady_clock::time_point lastDelivered{};  // under fusionMutex
+            std::size_t staleResults{ 0 };  // finished after a newer frame; under fusionMutex
+            float captureScale{ 1.0f };  // sensor pixels per frame pixel
+        };
+
         AppController();
 
         void ttsWorker(TextToSpeech& tts);
-        void detectionWorker(QRDetector& detector, QRReader& reader, RouteGuidance& guider); 
+        void captureWorker(Camera& camera);
+        void detectionWorker(Camera& camera, std::size_t worker);
+        // Tracks, detects and decodes one frame from `camera` on `worker`, then
+        // lets the fusion stage decide whether this camera's view drives
+        // guidance. Times come from the frame. With a worker pool, a result
+        // that finishes after one for a newer frame is dropped.
+        FrameResult processFrame(Camera& camera, Worker& worker, FrameContext& ctx);
 
-        cv::Mat waitForNextFrame();
-        void queueFrame(const cv::Mat& frame);
-        bool isCloseEnough(const QRCode& qr) const;
+        FrameContext* waitForNextFrame(FrameRing& ring, int consumer);
+        bool isCloseEnough(const QRCode& qr, float captureScale) const;
         cv::Mat extractQRROI(const QRCode& qr, const cv::Mat& frame);
 
         std::string decodeQR(const cv::Mat& roi);
-        void handleDecodedQR(const std::string& content);
+        std::string decodeMultiScale(Worker& worker, const QRCode& qr, FrameContext& ctx, cv::Mat& roiOut);
+        void handleDecodedQR(const std::string& content, std::chrono::steady_clock::time_point scanned,
+                             std::chrono::steady_clock::time_point visibleSince);
         
-        void maybeAdvanceStep();
+        void maybeAdvanceStep(std::chrono::steady_clock::time_point now);
         void setInstruction(const std::string& text);
 
-        void updateGuidanceOverlay(const QRCode& qr, const cv::Size& frameSize);
-        void drawOverlay(cv::Mat& frame);
-        void showComposite(const cv::Mat& frame);
+        void updateGuidanceOverlay(const Camera& camera, const QRCode& qr, const cv::Size& frameSize);
+        void drawOverlay(cv::Mat& view, const cv::Size& frameSize);
+        void showComposite(FrameContext& ctx);
 
         bool checkForExitKey();
+        // Replaces the default camera, e.g. with a recorded MJPEG file.
+        void setFrameSource(std::unique_ptr<FrameSource> source);
+        // Another camera (e.g. a side view); codes it sees compete with the
+        // first camera's in the fusion stage.
+        void addCamera(std::unique_ptr<FrameSource> source);
+        // Codes of this colour ("red", "green" or "blue") are searched for
+        // alongside the route colour and announced when read, but never
+        // followed. False for an unknown colour.
+        bool addAlertColour(const std::string& name);
+        // Capture raw YUV from the camera instead of MJPEG.
+        void setLumaCapture(bool enabled);
+        // No window: the capture loop only reads and dispatches frames, and
+        // SIGINT/SIGTERM end the run. Always on in NAVIGATION_HEADLESS builds.
+        void setHeadless(bool enabled);
+        // Detection threads per camera. 0 (the default) is one thread that
+        // tracks between throttled detections; n > 0 is a pool of n threads
+        // that each detect a whole frame, so successive frames run in parallel.
+        void setDetectionWorkers(int workers);
+        // Milliseconds of detection and decoding per second each camera may use
+        // outside a pool (0: no limit).
+        void setDetectionBudget(double msPerSecond);
+        // Image variants each detector tries at once on a candidate (1: one after another).
+        void setParallelVariants(int count);
+        // Treats the connection between two rooms as closed (a locked door, a lift
+        // out of service); routes avoid it. Applied when the map loads and again
+        // whenever a partition is loaded.
+        void addClosedConnection(const std::string& a, const std::string& b);
+        // Cap on window refreshes per second (0: every frame); capture isn't held to it.
+        void setUiRate(double fps);
+        // Where the per-stage latency report is rewritten every `interval` and
+        // on exit; empty for none.
+        void setLatencyLog(const std::string& path, std::chrono::seconds interval = std::chrono::seconds(10));
         void run();
+        // Feeds every frame of the frame source through processFrame on this
+        // thread, without prompts, window or speech, and logs what happened.
+        // Frame times come from the timestamps file or the frame rate, so runs
+        // are repeatable and, unless realTime, as fast as detection allows.
+        // With a worker pool the frames go through the pool instead, still all
+        // of them, which measures its throughput; results are then not logged.
+        bool replay(const ReplayOptions& options);
     public: 
         bool m_firstStepAfterQR{};
         cv::Mat lastQRROI{};
     private:
+        bool loadMap();
+        void configureCamera(Camera& camera, QRColour targetColour);
+        void printStats();
+        void dumpLatency(bool force);
         void handleNewQR(const std::string& content);
+        void applyPendingRoute();
+        PlannedRoute planRoute(const std::string& start, const std::string& goal);
+        std::vector<std::string> adjacentAnchors(const std::string& roomId) const;
+        std::optional<std::string> resolveRoom(const std::string& ident) const;
+        std::string roomDisplayName(const std::string& ident) const;
+        void applyClosedConnections(bool warn);
     private:
-        QRDetector detector;
+        std::vector<std::unique_ptr<Camera>> cameras{};  // [0] is the one shown
         QRReader reader;
+        std::mutex fusionMutex{};  // fusion, route and guidance updates from the detection threads
+        ObservationFusion fusion{};
+        std::vector<QRColour> alertColours{};
+        std::string lastAlert{};  // under fusionMutex
+        std::chrono::steady_clock::time_point lastAlertSeen{};  // under fusionMutex
+        bool lumaCapture{ false };
+        bool headless{ false };
+        int detectionWorkers{ 0 };
+        std::optional<double> detectionBudgetMs{};  // unset: default live, off in replay
+        int parallelVariants{ 1 };
+        std::vector<std::pair<std::string, std::string>> closedConnections{};
+        std::chrono::steady_clock::duration uiInterval{ std::chrono::milliseconds(66) };  // ~15 fps
+        std::chrono::steady_clock::time_point lastUiRender{};  // camera 0's capture thread
+        FrameRing uiRing{};  // camera 0 frames copied for the window, at most one per uiInterval
+        std::string latencyLogPath{ "latency.txt" };
+        std::chrono::seconds latencyDumpInterval{ 10 };
+        std::chrono::steady_clock::time_point lastLatencyDump{};
         CoordinateMapSystem mapSystem;
+        MapPartitionManager partitions;
         RouteGuidance guider;
         UIManager ui;
         
@@ -58,5 +186,8 @@ namespace NavigationVI{
 
         double unitScale{ 1.0 };
         double stepLengthM{ 0.75 };
+
+        std::shared_future<PlannedRoute> pendingRoute{};
+        RoutePlanner planner;
     };
 }
\ No newline at end of file
@@ -3,61 +3,69 @@
 namespace NavigationVI{
     UIManager::UIManager(const std::string& windowName, bool fullscreen, int width, int height)
         : m_windowName(windowName), m_fullscreen(fullscreen), m_width(width), m_height(height)
+        , m_canvas(MAIN_HEIGHT + TEXT_HEIGHT, MAIN_WIDTH + SIDE_WIDTH, CV_8UC3, cv::Scalar(0, 0, 0))
+        , m_mainRect(0, 0, MAIN_WIDTH, MAIN_HEIGHT)
+        , m_maskRect(MAIN_WIDTH, 0, SIDE_WIDTH, MAIN_HEIGHT / 2)
+        , m_qrRect(MAIN_WIDTH, MAIN_HEIGHT / 2, SIDE_WIDTH, MAIN_HEIGHT / 2)
+        , m_textRect(0, MAIN_HEIGHT, MAIN_WIDTH + SIDE_WIDTH, TEXT_HEIGHT)
     {
+    }
+
+    void UIManager::ensureWindow() const {
+#ifndef NAVIGATION_HEADLESS
+        if (m_windowCreated) return;
         cv::namedWindow(m_windowName, cv::WINDOW_NORMAL);
         if (m_fullscreen) {
             cv::setWindowProperty(m_windowName, cv::WND_PROP_FULLSCREEN, cv::WINDOW_FULLSCREEN);
         } else {
             cv::resizeWindow(m_windowName, m_width, m_height);
         }
+        m_windowCreated = true;
+#endif
     }
 
-    cv::Mat UIManager::makeComposite(const cv::Mat& mainFeed,
-                                    const cv::Mat& mask,
-                                    const cv::Mat& qrROI) const
-    {
-        cv::Mat mainResized;
-        cv::resize(mainFeed, mainResized, cv::Size(640, 480));
-
-        cv::Mat maskBGR;
-        if (mask.channels() == 1) {
-            cv::cvtColor(mask, maskBGR, cv::COLOR_GRAY2BGR);
-        } else {
-            maskBGR = mask.clone();
+    void UIManager::drawInto(const cv::Mat& src, cv::Mat dst, cv::Mat& scratch) {
+        // dst already has the right size and type, so resize/cvtColor write
+        // into the canvas instead of allocating.
+        if (src.channels() == 3) {
+            cv::resize(src, dst, dst.size());
+            return;
         }
-        cv::Mat maskResized;
-        cv::resize(maskBGR, maskResized, cv::Size(320, 240));
+        cv::resize(src, scratch, dst.size());
+        cv::cvtColor(scratch, dst, cv::COLOR_GRAY2BGR);
+    }
 
-        cv::Mat qrDisplay;
-        if (!qrROI.empty()) {
-            cv::resize(qrROI, qrDisplay, cv::Size(320, 240));
-        } else {
-            qrDisplay = cv::Mat::zeros(240, 320, CV_8UC3);
-        }
+    void UIManager::setMainFeed(const cv::Mat& frame) {
+        if (frame.empty()) return;
+        drawInto(frame, m_canvas(m_mainRect), m_mainScratch);
+    }
 
-        cv::Mat sidePanel;
-        cv::vconcat(maskResized, qrDisplay, sidePanel);
+    void UIManager::setMask(const cv::Mat& mask) {
+        if (mask.empty()) m_canvas(m_maskRect).setTo(cv::Scalar(0, 0, 0));
+        else drawInto(mask, m_canvas(m_maskRect), m_maskScratch);
+    }
 
-        // Pad side panel to match main feed height
-        if (sidePanel.rows < mainResized.rows) {
-            cv::copyMakeBorder(sidePanel, sidePanel, 0,
-                            mainResized.rows - sidePanel.rows,
-                            0, 0, cv::BORDER_CONSTANT, cv::Scalar(0,0,0));
+    void UIManager::setQRPreview(const cv::Mat& qrROI) {
+        if (qrROI.empty()) {
+            if (!m_qrEmpty) m_canvas(m_qrRect).setTo(cv::Scalar(0, 0, 0));
+            m_qrEmpty = true;
+            return;
         }
-
-        cv::Mat composite;
-        cv::hconcat(mainResized, sidePanel, composite);
-
-        return composite;
+        drawInto(qrROI, m_canvas(m_qrRect), m_qrScratch);
+        m_qrEmpty = false;
     }
 
-    cv::Mat UIManager::addTextPanel(const cv::Mat& composite,
-                                    const std::string& lastQR,
-                                    const std::string& destination,
-                                    const std::string& suggestion) const
-    {
-        int panelHeight = 80;
-        cv::Mat textPanel(panelHeight, composite.cols, CV_8UC3, cv::Scalar(50, 50, 50));
+    void UIManager::setText(const std::string& lastQR,
+                            const std::string& destination,
+                            const std::string& suggestion) {
+        if (m_textValid && lastQR == m_lastQR && destination == m_destination && suggestion == m_suggestion) return;
+        m_lastQR = lastQR;
+        m_destination = destination;
+        m_suggestion = suggestion;
+        m_textValid = true;
+
+        cv::Mat textPanel{ m_canvas(m_textRect) };
+        textPanel.setTo(cv::Scalar(50, 50, 50));
 
         cv::putText(textPanel, "Last scanned QR: " + lastQR,
                     {10, 25}, cv::FONT_HERSHEY_SIMPLEX, 0.6,
@@ -70,13 +78,15 @@ namespace NavigationVI{
         cv::putText(textPanel, "Suggestion: " + suggestion,
                     {10, 75}, cv::FONT_HERSHEY_SIMPLEX, 0.6,
                     {0, 255, 0}, 1);
-
-        cv::Mat stacked;
-        cv::vconcat(composite, textPanel, stacked);
-        return stacked;
     }
 
-    void UIManager::showWindow(const cv::Mat& composite) const {
-        cv::imshow(m_windowName, composite);
+    cv::Mat UIManager::mainPanel() { return m_canvas(m_mainRect); }
+    cv::Size UIManager::mainPanelSize() const { return m_mainRect.size(); }
+
+    void UIManager::showWindow() const {
+#ifndef NAVIGATION_HEADLESS
+        ensureWindow();
+        cv::imshow(m_windowName, m_canvas);
+#endif
     }
-}
\ No newline at end of file
+}
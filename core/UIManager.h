@@ -3,35 +3,63 @@
 #include <string>
 
 namespace NavigationVI{
+    // Navigation view: camera feed on the left, colour mask and last decoded
+    // code on the right, text panel underneath. Everything is drawn into one
+    // canvas allocated up front; each panel is resized straight into its
+    // rectangle, and the text panel is redrawn only when its strings change.
     class UIManager{
     public:
         UIManager(
             const std::string& windowName = "Navigation View",
             bool fullscreen = true,
-            int width = 1280, 
+            int width = 1280,
             int height = 720);
 
-        cv::Mat makeComposite(
-            const cv::Mat& mainFeed, 
-            const cv::Mat& mask,
-            const cv::Mat& qrROI) const;
-        
-        cv::Mat addTextPanel(const cv::Mat& composite,
-                    const std::string& lastQR,
-                    const std::string& destination,
-                    const std::string& suggestion) const;
-
-        // void drawOverlay(cv::Mat& composite,
-        //             const std::string& lastQR,
-        //             const std::string& destination,
-        //             const std::string& suggestion) const;
-    
-        void showWindow(const cv::Mat& composite) const;
-    
+        // BGR or single-channel images of any size.
+        void setMainFeed(const cv::Mat& frame);
+        void setMask(const cv::Mat& mask);
+        void setQRPreview(const cv::Mat& qrROI);  // empty clears the panel
+        void setText(const std::string& lastQR,
+                     const std::string& destination,
+                     const std::string& suggestion);
+
+        // The feed's panel, for drawing overlays after setMainFeed.
+        cv::Mat mainPanel();
+        cv::Size mainPanelSize() const;
+
+        // A no-op in headless builds (NAVIGATION_HEADLESS), which don't link highgui.
+        void showWindow() const;
+
+    private:
+        void ensureWindow() const;
+        // Resizes `src` into `dst` (a canvas view), converting gray to BGR.
+        void drawInto(const cv::Mat& src, cv::Mat dst, cv::Mat& scratch);
+
     private:
+        static constexpr int MAIN_WIDTH{ 640 };
+        static constexpr int MAIN_HEIGHT{ 480 };
+        static constexpr int SIDE_WIDTH{ 320 };
+        static constexpr int TEXT_HEIGHT{ 80 };
+
         std::string m_windowName{};
         bool m_fullscreen{};
         int m_width{};
         int m_height{};
+        mutable bool m_windowCreated{ false };  // opened on first show, so replays stay headless
+
+        cv::Mat m_canvas{};
+        cv::Rect m_mainRect{};
+        cv::Rect m_maskRect{};
+        cv::Rect m_qrRect{};
+        cv::Rect m_textRect{};
+        cv::Mat m_mainScratch{};  // single-channel inputs are resized here first
+        cv::Mat m_maskScratch{};
+        cv::Mat m_qrScratch{};
+        bool m_qrEmpty{ true };
+
+        bool m_textValid{ false };
+        std::string m_lastQR{};
+        std::string m_destination{};
+        std::string m_suggestion{};
     };
-}
\ No newline at end of file
+}
@@ -1,9 +1,118 @@
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+
 #include "core/AppController.h"
+#ifdef NAVIGATION_HAVE_LIBJPEG
+#include "modules/MjpegSource.h"
+#endif
 
 using namespace NavigationVI;
 
-int main() {
+static std::unique_ptr<FrameSource> openRecording(const std::string& path) {
+    if (std::filesystem::is_directory(path)) return std::make_unique<ImageSequenceSource>(path);
+#ifdef NAVIGATION_HAVE_LIBJPEG
+    bool mjpeg{ path.size() > 6 && (path.substr(path.size() - 6) == ".mjpeg" || path.substr(path.size() - 5) == ".mjpg") };
+    if (mjpeg) return MjpegSource::fromFile(path, 2);
+#endif
+    return std::make_unique<VideoCaptureSource>(path);
+}
+
+// A camera index, a GStreamer pipeline (contains '!') or a recording.
+static std::unique_ptr<FrameSource> openCamera(const std::string& spec) {
+    bool index{ !spec.empty() && std::all_of(spec.begin(), spec.end(), [](unsigned char c) { return std::isdigit(c); }) };
+    if (index) return std::make_unique<VideoCaptureSource>(std::stoi(spec));
+    if (spec.find('!') != std::string::npos) return std::make_unique<VideoCaptureSource>(spec, cv::CAP_GSTREAMER);
+    return openRecording(spec);
+}
+
+// navigation [--luma] [--headless] [--camera source]... [--workers n] [--detect-budget ms]
+//            [--parallel-variants n] [--alert-colour red|green|blue]... [--closed room|room]...
+//            [--ui-fps n] [--latency-log file] [recording]
+//   --luma         capture raw YUV and run detection on the Y plane
+//   --camera       an extra camera: index, GStreamer pipeline or recording
+//   --workers      detection threads per camera, each detecting whole frames
+//                  (0, the default: one thread tracking between detections)
+//   --detect-budget
+//                  ms of detection per second per camera without --workers
+//                  (250, off with --replay unless given; 0 for no limit)
+//   --parallel-variants
+//                  image variants tried at once on each candidate (1; also with --replay)
+//   --alert-colour codes of this colour are announced but not followed (also with --replay)
+//   --closed       a connection routes must avoid, as in connections.txt (also with --replay)
+//   --headless     no window; stop with Ctrl+C or SIGTERM
+//   --ui-fps       window refreshes per second (15; 0 for every frame)
+//   --latency-log  where the per-stage latency report goes (latency.txt; "" for none)
+//   recording      replay a recorded MJPEG (or any video) file instead of the camera
+//
+// navigation --replay <video|image dir> --destination <room> [--colour red|green|blue|none]
+//            [--timestamps file] [--fps n] [--log file] [--realtime] [--workers n]
+//   Headless and deterministic: no prompts, window or speech; every frame is
+//   processed, as fast as possible unless --realtime. With --workers the pool
+//   processes them and the summary line gives its throughput (no --log).
+int main(int argc, char** argv) {
     AppController app{};
+    AppController::ReplayOptions replay{};
+    std::string replayInput{};
+    for (int i{ 1 }; i < argc; ++i) {
+        std::string arg{ argv[i] };
+        bool hasValue{ i + 1 < argc };
+        if (arg == "--luma") {
+            app.setLumaCapture(true);
+        } else if (arg == "--headless") {
+            app.setHeadless(true);
+        } else if (arg == "--camera" && hasValue) {
+            app.addCamera(openCamera(argv[++i]));
+        } else if (arg == "--workers" && hasValue) {
+            app.setDetectionWorkers(std::stoi(argv[++i]));
+        } else if (arg == "--detect-budget" && hasValue) {
+            app.setDetectionBudget(std::stod(argv[++i]));
+        } else if (arg == "--parallel-variants" && hasValue) {
+            app.setParallelVariants(std::stoi(argv[++i]));
+        } else if (arg == "--alert-colour" && hasValue) {
+            if (!app.addAlertColour(argv[++i])) {
+                std::cerr << "Unknown alert colour: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--closed" && hasValue) {
+            std::string spec{ argv[++i] };
+            auto bar{ spec.find('|') };
+            if (bar == std::string::npos) {
+                std::cerr << "Expected room|room for --closed: " << spec << "\n";
+                return 1;
+            }
+            app.addClosedConnection(spec.substr(0, bar), spec.substr(bar + 1));
+        } else if (arg == "--ui-fps" && hasValue) {
+            app.setUiRate(std::stod(argv[++i]));
+        } else if (arg == "--realtime") {
+            replay.realTime = true;
+        } else if (arg == "--replay" && hasValue) {
+            replayInput = argv[++i];
+        } else if (arg == "--colour" && hasValue) {
+            replay.colour = argv[++i];
+        } else if (arg == "--destination" && hasValue) {
+            replay.destination = argv[++i];
+        } else if (arg == "--timestamps" && hasValue) {
+            replay.timestampsPath = argv[++i];
+        } else if (arg == "--fps" && hasValue) {
+            replay.fps = std::stod(argv[++i]);
+        } else if (arg == "--log" && hasValue) {
+            replay.logPath = argv[++i];
+        } else if (arg == "--latency-log" && hasValue) {
+            app.setLatencyLog(argv[++i]);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown or incomplete option: " << arg << "\n";
+            return 1;
+        } else {
+            app.setFrameSource(openRecording(arg));
+        }
+    }
+
+    if (!replayInput.empty()) {
+        app.setFrameSource(openRecording(replayInput));
+        return app.replay(replay) ? 0 : 1;
+    }
     app.run();
     return 0;
 }
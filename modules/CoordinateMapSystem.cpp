@@ -11,6 +11,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <limits>
 
 #include "../utils/RouteTypes.h"
 #include "../utils/MapEntities.h"
@@ -19,6 +20,10 @@
 #include "CoordinateMapSystem.h"
 
 namespace NavigationVI{
+    static Point staticCenter(const StaticMapView& view, std::uint16_t idx){
+        return Point{ view.rooms[idx].m_x, view.rooms[idx].m_y };
+    }
+
     CoordinateMapSystem::CoordinateMapSystem(
         const std::string& buildingName, 
         const std::string& floorName)
@@ -26,13 +31,27 @@ namespace NavigationVI{
         , m_floorName(floorName) {}
 
 
-        std::unordered_map<std::string, Room> CoordinateMapSystem::getRooms() const{
-            return m_rooms;
+        const std::unordered_map<std::string, Room>& CoordinateMapSystem::getRooms() const{ return m_rooms; }
+
+        void CoordinateMapSystem::useStaticMap(const StaticMapView& view){
+            m_rooms.clear();
+            m_connections.clear();
+            m_static = view;
+            rebuildComponents();
+            rebuildTurnTable();
+            reportUnreachableRooms();
+        }
+
+        bool CoordinateMapSystem::isStaticMap() const{
+            return !m_static.empty();
         }
 
+        const StaticMapView& CoordinateMapSystem::staticMap() const{ return m_static; }
+
         void CoordinateMapSystem::addRoom(const Room& room) {
             m_rooms.emplace(room.m_id, room);
             m_connections[room.m_id];
+            m_componentsDirty = true;
         }
 
         void CoordinateMapSystem::addConnection(const Connection& c){
@@ -51,10 +70,279 @@ namespace NavigationVI{
             m_connections[c.toRoom].push_back(rev);
             m_rooms[c.fromRoom].addConnections(c.toRoom);
             m_rooms[c.toRoom].addConnections(c.fromRoom);
+            m_componentsDirty = true;
+            m_turnsDirty = true;
+        }
+
+        bool CoordinateMapSystem::hasRoom(const std::string& roomId) const{
+            if (isStaticMap()) return m_static.findById(roomId).has_value();
+            return m_rooms.find(roomId) != m_rooms.end();
+        }
+
+        std::optional<std::string> CoordinateMapSystem::roomName(const std::string& roomId) const{
+            if (isStaticMap()){
+                auto idx{ m_static.findById(roomId) };
+                if (!idx) return std::nullopt;
+                return std::string(m_static.rooms[*idx].m_name);
+            }
+            auto it{ m_rooms.find(roomId) };
+            if (it == m_rooms.end()) return std::nullopt;
+            return it->second.m_name;
+        }
+
+        void CoordinateMapSystem::removeRoom(const std::string& roomId){
+            auto it{ m_connections.find(roomId) };
+            if (it != m_connections.end()){
+                for (const auto& c : it->second){
+                    auto back{ m_connections.find(c.toRoom) };
+                    if (back != m_connections.end()){
+                        auto& list{ back->second };
+                        list.erase(std::remove_if(list.begin(), list.end(),
+                            [&roomId](const Connection& rc){ return rc.toRoom == roomId; }), list.end());
+                    }
+                    auto nb{ m_rooms.find(c.toRoom) };
+                    if (nb != m_rooms.end()) nb->second.m_connections.erase(roomId);
+                }
+                m_connections.erase(it);
+            }
+            m_rooms.erase(roomId);
+            m_componentsDirty = true;
+            m_turnsDirty = true;
+        }
+
+        bool CoordinateMapSystem::addConnectionBetween(const std::string& a, const std::string& b, const std::string& type){
+            auto ra{ m_rooms.find(a) };
+            auto rb{ m_rooms.find(b) };
+            if (ra == m_rooms.end() || rb == m_rooms.end()) return false;
+            if (getConnection(a, b)) return true;
+
+            float dist{ ra->second.m_center.distanceTo(rb->second.m_center) };
+            addConnection(Connection{ a, b, dist, type, {}, true, 0.0f });
+            return true;
+        }
+
+        bool CoordinateMapSystem::setConnectionAccessible(const std::string& a, const std::string& b, bool accessible){
+            if (isStaticMap()) return false;
+
+            bool changed{ false };
+            auto flip{ [&](const std::string& from, const std::string& to) {
+                auto it{ m_connections.find(from) };
+                if (it == m_connections.end()) return;
+                for (auto& c : it->second){
+                    if (c.toRoom == to && c.isAccessible != accessible){
+                        c.isAccessible = accessible;
+                        changed = true;
+                    }
+                }
+            } };
+            flip(a, b);
+            flip(b, a);
+            if (!changed) return false;
+
+            // Opening a connection can only merge two components; closing one may
+            // split a component, which needs a full relabel.
+            auto ca{ m_componentOf.find(a) };
+            auto cb{ m_componentOf.find(b) };
+            if (accessible && !m_componentsDirty && ca != m_componentOf.end() && cb != m_componentOf.end()){
+                int keep{ ca->second };
+                int drop{ cb->second };
+                if (keep != drop){
+                    if (m_componentSizes[keep] < m_componentSizes[drop]) std::swap(keep, drop);
+                    for (auto& [id, label] : m_componentOf){
+                        if (label == drop) label = keep;
+                    }
+                    m_componentSizes[keep] += m_componentSizes[drop];
+                    m_componentSizes[drop] = 0;
+                }
+            } else {
+                rebuildComponents();
+            }
+            return true;
+        }
+
+        void CoordinateMapSystem::rebuildTurnTable(){
+            m_turnTable.clear();
+            m_turnsDirty = false;
+            if (isStaticMap()) return;  // compiled in by buildTurnTable
+
+            m_turnTable.reserve(m_connections.size());
+            for (const auto& [via, conns] : m_connections){
+                auto vr{ m_rooms.find(via) };
+                if (vr == m_rooms.end()) continue;
+                const Point& v{ vr->second.m_center };
+
+                // Direction out of via towards each neighbour: first waypoint that
+                // isn't on top of via, else the neighbour's centre. The incoming
+                // direction from that neighbour is the same vector reversed.
+                std::vector<Point> lead{};
+                lead.reserve(conns.size());
+                TurnRow row{};
+                row.neighbours.reserve(conns.size());
+                for (const auto& c : conns){
+                    Point target{ v };
+                    auto nr{ m_rooms.find(c.toRoom) };
+                    if (nr != m_rooms.end()) target = nr->second.m_center;
+                    for (const auto& wp : c.wayPoints){
+                        if (wp.distanceTo(v) > 0.05f){ target = wp; break; }
+                    }
+                    row.neighbours.push_back(c.toRoom);
+                    lead.push_back(Point{ target.m_x - v.m_x, target.m_y - v.m_y });
+                }
+
+                std::size_t deg{ conns.size() };
+                row.turns.resize(deg * deg);
+                for (std::size_t i{ 0 }; i < deg; ++i){
+                    for (std::size_t j{ 0 }; j < deg; ++j){
+                        row.turns[i * deg + j] = classifyTurn(-lead[i].m_x, -lead[i].m_y, lead[j].m_x, lead[j].m_y);
+                    }
+                }
+                m_turnTable.emplace(via, std::move(row));
+            }
+        }
+
+        std::optional<TurnType> CoordinateMapSystem::turnAt(
+            const std::string& prev,
+            const std::string& via,
+            const std::string& next) const{
+            if (isStaticMap()){
+                auto v{ m_static.findById(via) };
+                if (!v || m_static.turns == nullptr) return std::nullopt;
+                std::uint32_t begin{ m_static.rowOffsets[*v] };
+                std::uint32_t deg{ m_static.rowOffsets[*v + 1] - begin };
+                std::optional<std::uint32_t> in{}, out{};
+                for (std::uint32_t k{ 0 }; k < deg; ++k){
+                    std::string_view id{ m_static.rooms[m_static.adjacency[begin + k]].m_id };
+                    if (!in && id == prev) in = k;
+                    if (!out && id == next) out = k;
+                }
+                if (!in || !out) return std::nullopt;
+                return m_static.turns[m_static.turnOffsets[*v] + *in * deg + *out];
+            }
+
+            if (m_turnsDirty) return std::nullopt;
+            auto it{ m_turnTable.find(via) };
+            if (it == m_turnTable.end()) return std::nullopt;
+            const auto& nb{ it->second.neighbours };
+            auto in{ std::find(nb.begin(), nb.end(), prev) };
+            auto out{ std::find(nb.begin(), nb.end(), next) };
+            if (in == nb.end() || out == nb.end()) return std::nullopt;
+            std::size_t deg{ nb.size() };
+            return it->second.turns[static_cast<std::size_t>(in - nb.begin()) * deg +
+                                    static_cast<std::size_t>(out - nb.begin())];
+        }
+
+        std::optional<Point> CoordinateMapSystem::roomCenter(const std::string& roomId) const{
+            if (isStaticMap()){
+                auto idx{ m_static.findById(roomId) };
+                if (!idx) return std::nullopt;
+                return staticCenter(m_static, *idx);
+            }
+            auto it{ m_rooms.find(roomId) };
+            if (it == m_rooms.end()) return std::nullopt;
+            return it->second.m_center;
+        }
+
+        void CoordinateMapSystem::rebuildComponents(){
+            m_componentOf.clear();
+            m_componentSizes.clear();
+            m_componentsDirty = false;
+            if (isStaticMap()) return;
+
+            m_componentOf.reserve(m_rooms.size());
+            std::vector<std::string> stack{};
+            for (const auto& [seed, room] : m_rooms){
+                if (m_componentOf.count(seed)) continue;
+                int label{ static_cast<int>(m_componentSizes.size()) };
+                std::size_t size{ 0 };
+
+                m_componentOf.emplace(seed, label);
+                stack.push_back(seed);
+                while (!stack.empty()){
+                    std::string u{ std::move(stack.back()) };
+                    stack.pop_back();
+                    ++size;
+
+                    auto it{ m_connections.find(u) };
+                    if (it == m_connections.end()) continue;
+                    for (const auto& c : it->second){
+                        if (!c.isAccessible || !m_rooms.count(c.toRoom)) continue;
+                        if (m_componentOf.emplace(c.toRoom, label).second) stack.push_back(c.toRoom);
+                    }
+                }
+                m_componentSizes.push_back(size);
+            }
+        }
+
+        std::optional<int> CoordinateMapSystem::componentOf(const std::string& roomId) const{
+            if (isStaticMap()){
+                auto idx{ m_static.findById(roomId) };
+                if (!idx) return std::nullopt;
+                return static_cast<int>(m_static.componentLabels[*idx]);
+            }
+            auto it{ m_componentOf.find(roomId) };
+            if (it == m_componentOf.end()) return std::nullopt;
+            return it->second;
+        }
+
+        std::vector<std::size_t> CoordinateMapSystem::getComponentSizes() const{
+            if (isStaticMap()){
+                std::vector<std::size_t> sizes{};
+                for (std::size_t i{ 0 }; i < m_static.roomCount; ++i){
+                    std::size_t label{ m_static.componentLabels[i] };
+                    if (label >= sizes.size()) sizes.resize(label + 1, 0);
+                    ++sizes[label];
+                }
+                return sizes;
+            }
+            std::vector<std::size_t> sizes{};
+            for (auto size : m_componentSizes){
+                if (size > 0) sizes.push_back(size);
+            }
+            return sizes;
+        }
+
+        bool CoordinateMapSystem::isReachable(const std::string& a, const std::string& b) const{
+            auto ca{ componentOf(a) };
+            auto cb{ componentOf(b) };
+            return ca && cb && *ca == *cb;
+        }
+
+        void CoordinateMapSystem::reportUnreachableRooms() const{
+            // Static labels are dense; m_componentSizes keeps merged-away labels at 0.
+            std::vector<std::pair<std::string_view, int>> labels{};
+            std::vector<std::size_t> sizes{};
+            if (isStaticMap()){
+                labels.reserve(m_static.roomCount);
+                for (std::size_t i{ 0 }; i < m_static.roomCount; ++i){
+                    std::size_t label{ m_static.componentLabels[i] };
+                    if (label >= sizes.size()) sizes.resize(label + 1, 0);
+                    ++sizes[label];
+                    labels.emplace_back(m_static.rooms[i].m_id, static_cast<int>(label));
+                }
+            } else {
+                sizes = m_componentSizes;
+                labels.reserve(m_componentOf.size());
+                for (const auto& [id, label] : m_componentOf) labels.emplace_back(id, label);
+            }
+            if (sizes.size() < 2) return;
+
+            int main{ static_cast<int>(std::distance(sizes.begin(), std::max_element(sizes.begin(), sizes.end()))) };
+            for (const auto& [id, label] : labels){
+                if (label == main) continue;
+                std::cerr << "Warning: room " << id << " is unreachable from the main map ("
+                          << sizes[label] << " room(s) in its component)\n";
+            }
         }
 
         std::vector<std::string> CoordinateMapSystem::getNeighbours(const std::string& roomId) const{
             std::vector<std::string> neighbours{};
+            if (isStaticMap()){
+                auto idx{ m_static.findById(roomId) };
+                if (!idx) return neighbours;
+                for (std::uint32_t e{ m_static.rowOffsets[*idx] }; e < m_static.rowOffsets[*idx + 1]; ++e)
+                    neighbours.emplace_back(m_static.rooms[m_static.adjacency[e]].m_id);
+                return neighbours;
+            }
             auto it{ m_connections.find(roomId) };
             if (it != m_connections.end()){
                 for (const auto& c : it->second){
@@ -65,6 +353,15 @@ namespace NavigationVI{
         }
 
         std::optional<Connection> CoordinateMapSystem::getConnection(const std::string& a, const std::string& b) const {
+            if (isStaticMap()){
+                auto ia{ m_static.findById(a) };
+                auto ib{ m_static.findById(b) };
+                if (!ia || !ib) return std::nullopt;
+                for (std::uint32_t e{ m_static.rowOffsets[*ia] }; e < m_static.rowOffsets[*ia + 1]; ++e){
+                    if (m_static.adjacency[e] == *ib) return Connection{ a, b, m_static.edgeCosts[e] };
+                }
+                return std::nullopt;
+            }
             auto it{ m_connections.find(a) };
             if (it != m_connections.end()){
                 for (const auto& c : it->second){
@@ -75,10 +372,18 @@ namespace NavigationVI{
         }
 
         float CoordinateMapSystem::heuristic(const std::string& a, const std::string& b) const{
+            if (isStaticMap()){
+                auto ia{ m_static.findById(a) };
+                auto ib{ m_static.findById(b) };
+                if (!ia || !ib) return 0.0f;
+                return staticCenter(m_static, *ia).distanceTo(staticCenter(m_static, *ib));
+            }
             return m_rooms.at(a).m_center.distanceTo(m_rooms.at(b).m_center);
         }
 
         float CoordinateMapSystem::connectionLength(const Connection& conn) const{
+            // Embedded edge costs are precomputed and the tables carry no waypoints.
+            if (isStaticMap()) return conn.distance;
             if (conn.fromRoom.find("CORRIDOR") != std::string::npos ||
                 conn.toRoom.find("CORRIDOR") != std::string::npos) return conn.distance;
             
@@ -97,9 +402,21 @@ namespace NavigationVI{
             return connectionLength(conn);
         }
 
-        std::vector<Point> CoordinateMapSystem::stitchWayPoints(std::vector<std::string> pathIds){
+        std::vector<Point> CoordinateMapSystem::stitchWayPoints(std::vector<std::string> pathIds) const{
             if (pathIds.empty()) return {};
 
+            if (isStaticMap()){
+                std::vector<Point> pts{};
+                pts.reserve(pathIds.size());
+                for (const auto& id : pathIds){
+                    auto idx{ m_static.findById(id) };
+                    if (!idx) continue;
+                    Point p{ staticCenter(m_static, *idx) };
+                    if (pts.empty() || pts.back().distanceTo(p) > 0.05f) pts.push_back(p);
+                }
+                return pts;
+            }
+
             std::vector<Point> pts{};
             pts.push_back(m_rooms.at(pathIds[0]).m_center);
 
@@ -122,7 +439,14 @@ namespace NavigationVI{
         PathResult CoordinateMapSystem::aStarPathFind(
             const std::string& startRoom,
             const std::string& goalRoom 
-        ){
+        ) const{
+            if (isStaticMap()){
+                auto s{ m_static.findById(startRoom) };
+                auto g{ m_static.findById(goalRoom) };
+                if (!s || !g) return PathResult{{}, 0.0f, {}, false, 0.0f};
+                return aStarPathFindStatic(*s, *g);
+            }
+
             auto t0{ std::chrono::high_resolution_clock::now() };
             
             if (m_rooms.find(startRoom) == m_rooms.end() || 
@@ -141,13 +465,21 @@ namespace NavigationVI{
                 return PathResult{{startRoom}, 0.0f, {m_rooms.at(startRoom).m_center}, true, elapsed};
             }
 
+            // Labels are stale between a mutation and the next rebuild; fall back to searching.
+            if (!m_componentsDirty && !isReachable(startRoom, goalRoom)){
+                auto elapsed{ std::chrono::duration<float>(
+                    std::chrono::high_resolution_clock::now() - t0).count() };
+                return PathResult{{}, 0.0f, {}, false, elapsed};
+            }
+
             std::priority_queue<PQEntry, std::vector<PQEntry>, std::greater<PQEntry>> openHeap{};
             std::unordered_map<std::string, Node> openMap{};
             std::unordered_set<std::string> closed{};
+            int pushCounter{ 0 };
 
             float h0{ heuristic(startRoom, goalRoom) };
             openMap[startRoom] = Node{ startRoom, 0.0f, h0, std::nullopt };
-            openHeap.push(PQEntry{h0, h0, ++m_pushCounter, startRoom});
+            openHeap.push(PQEntry{h0, h0, ++pushCounter, startRoom});
 
             while(!openHeap.empty()){
                 std::string uId{ openHeap.top().m_nodeId };
@@ -188,7 +520,7 @@ namespace NavigationVI{
                         float h{ heuristic(vId, goalRoom) };
                         openMap[vId] = Node(vId, tentativeG, h, uId);
                         float f{ tentativeG + h };
-                        openHeap.push(PQEntry{f, h, ++m_pushCounter, vId});
+                        openHeap.push(PQEntry{f, h, ++pushCounter, vId});
                     }
                 }
             }
@@ -201,7 +533,82 @@ namespace NavigationVI{
             return PathResult{ {}, 0.0f, {}, false, elapsed };
         }
 
-        PathResult CoordinateMapSystem::findShortestPath(const std::string& startRoom, const std::string& goalRoom, bool _verbose){
+        PathResult CoordinateMapSystem::aStarPathFindStatic(std::uint16_t start, std::uint16_t goal) const{
+            auto t0{ std::chrono::high_resolution_clock::now() };
+            auto elapsedSince{ [&t0]() {
+                return std::chrono::duration<float>(
+                    std::chrono::high_resolution_clock::now() - t0).count();
+            } };
+
+            if (start == goal){
+                return PathResult{
+                    {std::string(m_static.rooms[start].m_id)}, 0.0f,
+                    {staticCenter(m_static, start)}, true, elapsedSince() };
+            }
+
+            if (m_static.componentLabels[start] != m_static.componentLabels[goal])
+                return PathResult{ {}, 0.0f, {}, false, elapsedSince() };
+
+            // Same ordering as PQEntry (f, then h, then insertion order) but keyed by index.
+            struct Entry{
+                float f{};
+                float h{};
+                int counter{};
+                std::uint16_t node{};
+                bool operator>(const Entry& o) const {
+                    if (f == o.f){
+                        if (h == o.h) return counter > o.counter;
+                        return h > o.h;
+                    }
+                    return f > o.f;
+                }
+            };
+
+            const std::size_t n{ m_static.roomCount };
+            const Point goalCenter{ staticCenter(m_static, goal) };
+            std::vector<float> g(n, std::numeric_limits<float>::infinity());
+            std::vector<int> parent(n, -1);
+            std::vector<bool> closed(n, false);
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> openHeap{};
+            int counter{ 0 };
+
+            float h0{ staticCenter(m_static, start).distanceTo(goalCenter) };
+            g[start] = 0.0f;
+            openHeap.push(Entry{ h0, h0, ++counter, start });
+
+            while (!openHeap.empty()){
+                std::uint16_t u{ openHeap.top().node };
+                openHeap.pop();
+                if (closed[u]) continue;
+                closed[u] = true;
+
+                if (u == goal){
+                    std::vector<std::string> path{};
+                    for (int cur{ u }; cur != -1; cur = parent[cur])
+                        path.emplace_back(m_static.rooms[cur].m_id);
+                    std::reverse(path.begin(), path.end());
+                    float total{ g[u] };
+                    auto wayPoints{ stitchWayPoints(path) };
+                    return PathResult{ std::move(path), total, std::move(wayPoints), true, elapsedSince() };
+                }
+
+                for (std::uint32_t e{ m_static.rowOffsets[u] }; e < m_static.rowOffsets[u + 1]; ++e){
+                    std::uint16_t v{ m_static.adjacency[e] };
+                    if (closed[v]) continue;
+                    float tentativeG{ g[u] + m_static.edgeCosts[e] };
+                    if (tentativeG < g[v] - 1e-12f){
+                        g[v] = tentativeG;
+                        parent[v] = u;
+                        float h{ staticCenter(m_static, v).distanceTo(goalCenter) };
+                        openHeap.push(Entry{ tentativeG + h, h, ++counter, v });
+                    }
+                }
+            }
+
+            return PathResult{ {}, 0.0f, {}, false, elapsedSince() };
+        }
+
+        PathResult CoordinateMapSystem::findShortestPath(const std::string& startRoom, const std::string& goalRoom, bool _verbose) const{
             auto sId{ resolveRoomId(startRoom) };
             auto gId{ resolveRoomId(goalRoom) };
 
@@ -212,6 +619,11 @@ namespace NavigationVI{
 
 
         std::optional<std::string> CoordinateMapSystem::resolveRoomId(const std::string& ident) const{
+            if (isStaticMap()){
+                if (auto idx{ m_static.findById(ident) }) return std::string(m_static.rooms[*idx].m_id);
+                if (auto idx{ m_static.findByName(ident) }) return std::string(m_static.rooms[*idx].m_id);
+                return std::nullopt;
+            }
             if (m_rooms.find(ident) != m_rooms.end()) return ident;
             std::string lowerIdent{ ident };
             std::transform(
@@ -233,6 +645,14 @@ namespace NavigationVI{
     }
 
     bool CoordinateMapSystem::loadRoomsFromFile(const std::string& filePath){
+        std::vector<Room> rooms{};
+        if (!readRoomsFile(filePath, rooms)) return false;
+        for (const auto& r : rooms) addRoom(r);
+        rebuildComponents();
+        return true;
+    }
+
+    bool CoordinateMapSystem::readRoomsFile(const std::string& filePath, std::vector<Room>& out){
         std::ifstream file(filePath);
         if (!file.is_open()) return false;
 
@@ -278,13 +698,31 @@ namespace NavigationVI{
             r.m_bounds = Rectangle{ x, y, w, h };
             r.m_center.m_x = x;
             r.m_center.m_y = y;
-            addRoom(r);
+            out.push_back(std::move(r));
         }
 
         return true;
     }
 
     bool CoordinateMapSystem::loadConnectionsFromFile(const std::string& filePath){
+        std::vector<ConnectionRecord> records{};
+        if (!readConnectionsFile(filePath, records)) return false;
+
+        for (const auto& rec : records){
+            Point pa{ m_rooms.at(rec.fromRoom).m_center };
+            Point pb{ m_rooms.at(rec.toRoom).m_center };
+            float dist{ pa.distanceTo(pb) };
+
+            Connection c{ rec.fromRoom, rec.toRoom, dist, rec.pathwayType, {}, true, 0.0f };
+            addConnection(c);
+        }
+        rebuildComponents();
+        rebuildTurnTable();
+        reportUnreachableRooms();
+        return true;
+    }
+
+    bool CoordinateMapSystem::readConnectionsFile(const std::string& filePath, std::vector<ConnectionRecord>& out){
         std::ifstream file(filePath);
         if (!file.is_open()) return false;
     
@@ -300,12 +738,7 @@ namespace NavigationVI{
             if (!std::getline(ss, b, '|')) continue;
             if (!std::getline(ss, type, '|')) continue;
 
-            Point pa{ m_rooms.at(a).m_center };
-            Point pb{ m_rooms.at(b).m_center };
-            float dist{ pa.distanceTo(pb) };
-
-            Connection c{ a, b, dist, type, {}, true, 0.0f };
-            addConnection(c);
+            out.push_back(ConnectionRecord{ a, b, type });
         }
 
         return true;
@@ -13,31 +13,79 @@
 #include "../utils/RouteTypes.h"
 #include "../utils/RouteInternal.h"
 #include "../utils/MapEntities.h"
+#include "../utils/StaticMap.h"
 
 namespace NavigationVI{
     class CoordinateMapSystem{
         public:
             CoordinateMapSystem(const std::string& buildingName, const std::string& floorName);
 
-            std::unordered_map<std::string, Room> getRooms() const; //new
+            // Rooms loaded from files. Empty for a static map, whose rooms are the
+            // compiled-in arrays behind staticMap(); hasRoom/roomName/roomCenter
+            // answer for either without copying.
+            const std::unordered_map<std::string, Room>& getRooms() const;
             void addRoom(const Room& room);
             void addConnection(const Connection& c);
+            bool hasRoom(const std::string& roomId) const;
+            std::optional<std::string> roomName(const std::string& roomId) const;
+            void removeRoom(const std::string& roomId);
+            // Adds a|b using the centre distance; false if either room isn't loaded.
+            bool addConnectionBetween(const std::string& a, const std::string& b, const std::string& type);
             std::vector<std::string> getNeighbours(const std::string& roomId) const;
             std::optional<Connection> getConnection(const std::string& a, const std::string& b) const;
             float heuristic(const std::string& a, const std::string& b) const;
             float connectionLength(const Connection& conn) const;
             float segmentCost(const Connection& con) const;
-            PathResult aStarPathFind(const std::string& startRoom, const std::string& goalRoom);
-            PathResult findShortestPath(const std::string& startRoom, const std::string& goalRoom, bool _verbose = false);
+            PathResult aStarPathFind(const std::string& startRoom, const std::string& goalRoom) const;
+            PathResult findShortestPath(const std::string& startRoom, const std::string& goalRoom, bool _verbose = false) const;
             bool loadRoomsFromFile(const std::string& filePath);
             bool loadConnectionsFromFile(const std::string& filePath);
-            std::vector<Point> stitchWayPoints(std::vector<std::string> pathIds);
+            static bool readRoomsFile(const std::string& filePath, std::vector<Room>& out);
+            static bool readConnectionsFile(const std::string& filePath, std::vector<ConnectionRecord>& out);
+            std::vector<Point> stitchWayPoints(std::vector<std::string> pathIds) const;
             std::optional<std::string> resolveRoomId(const std::string& indent) const;
+
+            // Runs all queries on compiled-in tables instead of m_rooms/m_connections.
+            // The view must outlive this object (EmbeddedMap tables are static).
+            void useStaticMap(const StaticMapView& view);
+            bool isStaticMap() const;
+            const StaticMapView& staticMap() const;
+
+            // Connected components over accessible connections. Labels are rebuilt
+            // after loading and whenever accessibility changes, so unreachable
+            // goals are rejected before A* explores anything.
+            bool setConnectionAccessible(const std::string& a, const std::string& b, bool accessible);
+            std::optional<int> componentOf(const std::string& roomId) const;
+            std::vector<std::size_t> getComponentSizes() const;
+            bool isReachable(const std::string& a, const std::string& b) const;
+            void rebuildComponents();
+            void reportUnreachableRooms() const;
+
+            // Turn classification for every (incoming, outgoing) connection pair at
+            // each room, precomputed so instruction generation is a table lookup.
+            // turnAt returns nullopt when prev/next aren't neighbours of via or the
+            // table is stale (call rebuildTurnTable after changing connections).
+            void rebuildTurnTable();
+            std::optional<TurnType> turnAt(const std::string& prev, const std::string& via, const std::string& next) const;
+            std::optional<Point> roomCenter(const std::string& roomId) const;
+        private:
+            PathResult aStarPathFindStatic(std::uint16_t start, std::uint16_t goal) const;
         private:
             std::string m_buildingName{};
             std::string m_floorName{};
             std::unordered_map<std::string, Room> m_rooms{};
             std::unordered_map<std::string, std::vector<Connection>> m_connections{};
-            int m_pushCounter{0};
+            StaticMapView m_static{};
+
+            std::unordered_map<std::string, int> m_componentOf{};
+            std::vector<std::size_t> m_componentSizes{};
+            bool m_componentsDirty{ true };
+
+            struct TurnRow{
+                std::vector<std::string> neighbours{};  // m_connections order
+                std::vector<TurnType> turns{};          // neighbours.size()^2, [in * deg + out]
+            };
+            std::unordered_map<std::string, TurnRow> m_turnTable{};
+            bool m_turnsDirty{ true };
     };
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "DecodeCache.h"
+
+#include <algorithm>
+
+namespace NavigationVI{
+    DecodeCache::Fingerprint DecodeCache::fingerprint(const cv::Mat& roi){
+        Fingerprint bits{};
+        if (roi.empty()) return bits;
+
+        cv::Mat gray{};
+        if (roi.channels() == 3) cv::cvtColor(roi, gray, cv::COLOR_BGR2GRAY);
+        else if (roi.channels() == 4) cv::cvtColor(roi, gray, cv::COLOR_BGRA2GRAY);
+        else gray = roi;
+
+        cv::Mat thumb{};
+        cv::resize(gray, thumb, cv::Size(FINGERPRINT_SIDE, FINGERPRINT_SIDE), 0, 0, cv::INTER_AREA);
+
+        // Median rather than a fixed level, so exposure changes don't flip bits.
+        std::vector<std::uint8_t> values{};
+        values.reserve(bits.size());
+        for (int y{ 0 }; y < thumb.rows; ++y) {
+            const std::uint8_t* row{ thumb.ptr<std::uint8_t>(y) };
+            values.insert(values.end(), row, row + thumb.cols);
+        }
+        auto mid{ values.begin() + values.size() / 2 };
+        std::nth_element(values.begin(), mid, values.end());
+        const std::uint8_t median{ *mid };
+
+        std::size_t i{ 0 };
+        for (int y{ 0 }; y < thumb.rows; ++y) {
+            const std::uint8_t* row{ thumb.ptr<std::uint8_t>(y) };
+            for (int x{ 0 }; x < thumb.cols; ++x, ++i)
+                if (row[x] < median) bits.set(i);
+        }
+        return bits;
+    }
+
+    std::optional<std::string> DecodeCache::lookup(const cv::Mat& roi, const cv::Point2f& position, Clock::time_point now){
+        ++m_stats.lookups;
+        Fingerprint print{ fingerprint(roi) };
+
+        for (auto it{ m_entries.begin() }; it != m_entries.end(); ++it) {
+            if (cv::norm(it->position - position) > m_maxShiftPx) continue;
+            if ((it->fingerprint ^ print).count() > MAX_FINGERPRINT_DISTANCE) continue;
+
+            if (now - it->decodedAt > m_ttl) {
+                ++m_stats.expired;
+                m_entries.erase(it);
+                return std::nullopt;
+            }
+            ++m_stats.hits;
+            return it->content;
+        }
+        return std::nullopt;
+    }
+
+    void DecodeCache::store(const cv::Mat& roi, const cv::Point2f& position, const std::string& content, Clock::time_point now){
+        if (content.empty()) return;
+
+        Entry entry{ fingerprint(roi), position, content, now };
+        // One entry per place: a new decode there replaces the old one.
+        auto same{ std::find_if(m_entries.begin(), m_entries.end(), [&](const Entry& e) {
+            return cv::norm(e.position - position) <= m_maxShiftPx;
+        }) };
+        if (same != m_entries.end()) {
+            *same = std::move(entry);
+            return;
+        }
+
+        if (m_entries.size() >= MAX_ENTRIES) {
+            auto oldest{ std::min_element(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {
+                return a.decodedAt < b.decodedAt;
+            }) };
+            m_entries.erase(oldest);
+        }
+        m_entries.push_back(std::move(entry));
+    }
+
+    void DecodeCache::clear(){ m_entries.clear(); }
+
+    void DecodeCache::setTimeToLive(std::chrono::milliseconds ttl){ m_ttl = ttl; }
+    void DecodeCache::setMaxShift(float px){ m_maxShiftPx = std::max(0.0f, px); }
+
+    DecodeCache::Stats DecodeCache::getStats() const { return m_stats; }
+}
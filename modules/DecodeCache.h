@@ -0,0 +1,62 @@
+#pragma once
+
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace NavigationVI{
+    // Remembers what recently decoded codes said, so a code that hasn't changed
+    // is not sent through ZBar again. Entries are keyed by a module-level
+    // fingerprint of the warped code image plus where the code was in the frame;
+    // a lookup matches within MAX_FINGERPRINT_DISTANCE bits and m_maxShiftPx
+    // pixels. Entries expire after m_ttl so a replaced sticker is eventually re-read.
+    class DecodeCache{
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            struct Stats{
+                std::size_t lookups{ 0 };
+                std::size_t hits{ 0 };
+                std::size_t expired{ 0 };  // matched but too old, decoded again
+            };
+
+            std::optional<std::string> lookup(const cv::Mat& roi, const cv::Point2f& position, Clock::time_point now);
+            void store(const cv::Mat& roi, const cv::Point2f& position, const std::string& content, Clock::time_point now);
+            void clear();
+
+            void setTimeToLive(std::chrono::milliseconds ttl);
+            void setMaxShift(float px);
+
+            Stats getStats() const;
+
+            // The warped code shrunk to FINGERPRINT_SIDE^2 cells, one bit per cell
+            // darker than the median. Low-frequency hashes can't tell QR codes apart
+            // (finder patterns dominate). At this size two different codes differ
+            // in a quarter or more of the bits through their data modules, while
+            // the same code re-warped a frame later flips only cells on module edges.
+            static constexpr int FINGERPRINT_SIDE{ 32 };
+            using Fingerprint = std::bitset<FINGERPRINT_SIDE * FINGERPRINT_SIDE>;
+            static Fingerprint fingerprint(const cv::Mat& roi);
+
+        private:
+            struct Entry{
+                Fingerprint fingerprint{};
+                cv::Point2f position{};
+                std::string content{};
+                Clock::time_point decodedAt{};
+            };
+
+            static constexpr std::size_t MAX_FINGERPRINT_DISTANCE{ FINGERPRINT_SIDE * FINGERPRINT_SIDE / 12 };
+            static constexpr std::size_t MAX_ENTRIES{ 16 };
+
+            std::vector<Entry> m_entries{};
+            std::chrono::milliseconds m_ttl{ 5000 };
+            float m_maxShiftPx{ 80.0f };
+            Stats m_stats{};
+    };
+}
@@ -0,0 +1,84 @@
+#include "DetectionScheduler.h"
+
+#include <algorithm>
+
+namespace NavigationVI{
+    bool DetectionScheduler::shouldDetect(FrameContext& ctx){
+        auto now{ ctx.captureTime() };
+        ++m_stats.frames;
+
+        cv::resize(ctx.gray(), m_thumb, cv::Size(THUMB_WIDTH, THUMB_HEIGHT), 0, 0, cv::INTER_AREA);
+        bool changed{ m_reference.empty() || sceneChange(m_thumb, m_reference) >= m_changeThreshold };
+        bool due{ now - m_lastDetection >= m_gap };
+        if (!changed && !due) {
+            ++m_stats.waited;
+            return false;
+        }
+        if (!withinBudget(now)) {
+            ++m_stats.overBudget;
+            return false;
+        }
+
+        if (changed) {
+            ++m_stats.sceneChanges;
+            m_gap = m_minGap;
+        }
+        // Later frames are compared with this one, so slow drift adds up too.
+        m_thumb.copyTo(m_reference);
+        m_lastDetection = now;
+        ++m_stats.detections;
+        return true;
+    }
+
+    bool DetectionScheduler::mayDecode(Clock::time_point now){
+        if (now - std::max(m_lastDetection, m_lastDecode) < m_gap) return false;
+        if (!withinBudget(now)) return false;
+        m_lastDecode = now;
+        return true;
+    }
+
+    void DetectionScheduler::record(Clock::time_point when, double costMs, bool found){
+        m_costs.emplace_back(when, costMs);
+        m_spentMs += costMs;
+        m_avgCostMs = m_avgCostMs > 0.0 ? m_avgCostMs + COST_ALPHA * (costMs - m_avgCostMs) : costMs;
+        m_stats.busyMs += costMs;
+        // Nothing in view: look less often for as long as the scene stays put.
+        m_gap = found ? m_minGap : std::min(m_gap * 2, m_maxGap);
+    }
+
+    void DetectionScheduler::restart(Clock::time_point now){
+        m_reference.release();
+        m_lastDetection = now;
+        m_lastDecode = now;
+        m_gap = m_minGap;
+        m_costs.clear();
+        m_spentMs = 0.0;
+    }
+
+    bool DetectionScheduler::withinBudget(Clock::time_point now){
+        while (!m_costs.empty() && now - m_costs.front().first >= std::chrono::seconds(1)) {
+            m_spentMs -= m_costs.front().second;
+            m_costs.pop_front();
+        }
+        if (m_budgetMsPerSecond <= 0.0 || m_costs.empty()) return true;
+        // Room for one more at the going rate.
+        return m_spentMs + m_avgCostMs <= m_budgetMsPerSecond;
+    }
+
+    void DetectionScheduler::setChangeThreshold(float meanAbsDiff){ m_changeThreshold = std::max(0.0f, meanAbsDiff); }
+
+    void DetectionScheduler::setGapRange(std::chrono::milliseconds minGap, std::chrono::milliseconds maxGap){
+        m_minGap = std::max(minGap, std::chrono::milliseconds(0));
+        m_maxGap = std::max(maxGap, m_minGap);
+        m_gap = m_minGap;
+    }
+
+    void DetectionScheduler::setCpuBudget(double msPerSecond){ m_budgetMsPerSecond = std::max(0.0, msPerSecond); }
+
+    DetectionScheduler::Stats DetectionScheduler::getStats() const { return m_stats; }
+
+    float DetectionScheduler::sceneChange(const cv::Mat& a, const cv::Mat& b){
+        if (a.empty() || a.size() != b.size()) return 255.0f;
+        return static_cast<float>(cv::norm(a, b, cv::NORM_L1) / static_cast<double>(a.total()));
+    }
+}
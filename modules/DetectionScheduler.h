@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <utility>
+
+#include <opencv2/opencv.hpp>
+
+#include "FrameContext.h"
+
+namespace NavigationVI{
+    // Decides which untracked frames get a full detection. Each frame is
+    // shrunk to a THUMB_WIDTH x THUMB_HEIGHT gray thumbnail and compared with
+    // the one from the last detection: a scene change detects straight away,
+    // while a static scene is only re-checked every m_gap, which doubles (up to
+    // m_maxGap) each time a detection finds nothing and drops back to m_minGap
+    // when one finds a code or the scene changes. On top of that, detection
+    // work is held to m_budgetMsPerSecond of processing per second of frames.
+    //
+    // Times are the frames' capture times; costs are measured processing time.
+    class DetectionScheduler{
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            struct Stats{
+                std::size_t frames{ 0 };      // asked about
+                std::size_t detections{ 0 };  // allowed
+                std::size_t sceneChanges{ 0 };  // allowed because the scene changed
+                std::size_t waited{ 0 };      // static scene, next check not due yet
+                std::size_t overBudget{ 0 };  // would have run but the budget was spent
+                double busyMs{ 0.0 };         // total recorded cost
+            };
+
+            bool shouldDetect(FrameContext& ctx);
+            // Whether a tracked frame at `now` may try a decode: the same gap and
+            // budget as detections, but no scene check, and the reference
+            // thumbnail and stats are left alone.
+            bool mayDecode(Clock::time_point now);
+            // Work done for the frame at `when` (a detection or a decode), and
+            // whether it found a code.
+            void record(Clock::time_point when, double costMs, bool found);
+            // Starts over as if a detection had just run at `now` on an unknown scene.
+            void restart(Clock::time_point now);
+
+            // Mean absolute difference of the thumbnails (0-255) that counts as a change.
+            void setChangeThreshold(float meanAbsDiff);
+            void setGapRange(std::chrono::milliseconds minGap, std::chrono::milliseconds maxGap);
+            // Milliseconds of detection per second; 0 for no limit.
+            void setCpuBudget(double msPerSecond);
+
+            Stats getStats() const;
+
+            // Mean absolute difference between two thumbnails.
+            static float sceneChange(const cv::Mat& a, const cv::Mat& b);
+
+        private:
+            bool withinBudget(Clock::time_point now);
+
+        private:
+            static constexpr int THUMB_WIDTH{ 32 };
+            static constexpr int THUMB_HEIGHT{ 24 };
+            static constexpr double COST_ALPHA{ 0.2 };
+
+            cv::Mat m_thumb{};
+            cv::Mat m_reference{};  // thumbnail at the last detection
+            Clock::time_point m_lastDetection{};
+            Clock::time_point m_lastDecode{};
+
+            float m_changeThreshold{ 6.0f };
+            std::chrono::milliseconds m_minGap{ 200 };
+            std::chrono::milliseconds m_maxGap{ 2000 };
+            std::chrono::milliseconds m_gap{ 200 };
+
+            double m_budgetMsPerSecond{ 250.0 };
+            std::deque<std::pair<Clock::time_point, double>> m_costs{};  // the last second's work
+            double m_spentMs{ 0.0 };
+            double m_avgCostMs{ 0.0 };
+
+            Stats m_stats{};
+    };
+}
@@ -0,0 +1,313 @@
+#include "FrameContext.h"
+
+#include <cmath>
+
+namespace NavigationVI{
+    FrameContext::FrameContext(cv::Mat bgr, Clock::time_point captured)
+        : FrameContext(std::move(bgr), PixelFormat::BGR, captured) {}
+
+    FrameContext::FrameContext(cv::Mat image, PixelFormat format, Clock::time_point captured)
+        : m_image(std::move(image))
+        , m_format(format)
+        , m_captured(captured) {}
+
+    cv::Mat& FrameContext::prepare(){
+        // A plane that views the image (NV12 luma) would be overwritten by the
+        // next fill, so it gives up the view rather than keep a buffer.
+        auto drop{ [this](Plane& p) {
+            p.valid = false;
+            if (!p.mat.empty() && p.mat.datastart == m_image.datastart) p.mat.release();
+        } };
+        drop(m_bgr);
+        drop(m_gray);
+        drop(m_smallBgr);
+        drop(m_smallGray);
+        for (auto& [colour, plane] : m_masks) drop(plane);
+        for (auto& [colour, plane] : m_smallMasks) drop(plane);
+        drop(m_labels);
+        drop(m_smallLabels);
+
+        m_fullScale = 1.0;
+        m_decodeRegion = nullptr;
+        return m_image;
+    }
+
+    void FrameContext::commit(PixelFormat format, Clock::time_point captured){
+        m_format = format;
+        m_captured = captured;
+    }
+
+    void FrameContext::copyFrom(const FrameContext& other){
+        other.m_image.copyTo(prepare());
+        commit(other.m_format, other.m_captured);
+    }
+
+    std::vector<uchar>& FrameContext::encoded(){ return m_encoded; }
+
+    FrameContext::PixelFormat FrameContext::format() const { return m_format; }
+    FrameContext::Clock::time_point FrameContext::captureTime() const { return m_captured; }
+    bool FrameContext::empty() const { return m_image.empty(); }
+
+    cv::Size FrameContext::size() const{
+        if (m_format == PixelFormat::NV12) return cv::Size{ m_image.cols, m_image.rows * 2 / 3 };
+        return m_image.size();
+    }
+
+    const cv::Mat& FrameContext::bgr(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return bgrLocked();
+    }
+
+    const cv::Mat& FrameContext::bgrLocked(){
+        if (m_format == PixelFormat::BGR) return m_image;
+        if (m_bgr.valid || m_image.empty()) return m_bgr.mat;
+        if (m_format == PixelFormat::GRAY) cv::cvtColor(m_image, m_bgr.mat, cv::COLOR_GRAY2BGR);
+        else if (m_format == PixelFormat::YUYV) cv::cvtColor(m_image, m_bgr.mat, cv::COLOR_YUV2BGR_YUYV);
+        else cv::cvtColor(m_image, m_bgr.mat, cv::COLOR_YUV2BGR_NV12);
+        m_bgr.valid = true;
+        return m_bgr.mat;
+    }
+
+    const cv::Mat& FrameContext::gray(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return grayLocked();
+    }
+
+    const cv::Mat& FrameContext::grayLocked(){
+        if (m_format == PixelFormat::GRAY) return m_image;
+        if (m_gray.valid || m_image.empty()) return m_gray.mat;
+        switch (m_format){
+            case PixelFormat::BGR:
+                cv::cvtColor(m_image, m_gray.mat, cv::COLOR_BGR2GRAY);
+                break;
+            case PixelFormat::NV12:
+                // The Y plane is the luminance; no copy.
+                m_gray.mat = m_image.rowRange(0, size().height);
+                break;
+            case PixelFormat::YUYV:
+                cv::extractChannel(m_image, m_gray.mat, 0);
+                break;
+            default:
+                break;
+        }
+        m_gray.valid = true;
+        return m_gray.mat;
+    }
+
+    const cv::Mat& FrameContext::smallGray(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_smallGray.valid && !m_image.empty()){
+            cv::resize(grayLocked(), m_smallGray.mat, cv::Size(), SMALL_SCALE, SMALL_SCALE, cv::INTER_AREA);
+            m_smallGray.valid = true;
+        }
+        return m_smallGray.mat;
+    }
+
+    const cv::Mat& FrameContext::smallBgr(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_smallBgr.valid || m_image.empty()) return m_smallBgr.mat;
+
+        const cv::Size full{ size() };
+        cv::Size small{ full.width / 2, full.height / 2 };
+        cv::Mat& out{ m_smallBgr.mat };
+        switch (m_format){
+            case PixelFormat::YUYV: {
+                // Each Y0 U Y1 V group on every other row becomes one (Y0, U, V) pixel.
+                cv::Mat groups{ m_image.reshape(4) };
+                cv::Mat yuv(small, CV_8UC3);
+                for (int y{ 0 }; y < small.height; ++y){
+                    const uchar* src{ groups.ptr<uchar>(2 * y) };
+                    uchar* dst{ yuv.ptr<uchar>(y) };
+                    for (int x{ 0 }; x < small.width; ++x, src += 4, dst += 3){
+                        dst[0] = src[0];
+                        dst[1] = src[1];
+                        dst[2] = src[3];
+                    }
+                }
+                cv::cvtColor(yuv, out, cv::COLOR_YUV2BGR);
+                break;
+            }
+            case PixelFormat::NV12: {
+                // Chroma is stored at half size already; pair it with every other Y.
+                cv::Mat uv{ m_image.rowRange(full.height, full.height + small.height).reshape(2) };
+                cv::Mat yuv(small, CV_8UC3);
+                for (int y{ 0 }; y < small.height; ++y){
+                    const uchar* luma{ m_image.ptr<uchar>(2 * y) };
+                    const uchar* chroma{ uv.ptr<uchar>(y) };
+                    uchar* dst{ yuv.ptr<uchar>(y) };
+                    for (int x{ 0 }; x < small.width; ++x, dst += 3){
+                        dst[0] = luma[2 * x];
+                        dst[1] = chroma[2 * x];
+                        dst[2] = chroma[2 * x + 1];
+                    }
+                }
+                cv::cvtColor(yuv, out, cv::COLOR_YUV2BGR);
+                break;
+            }
+            case PixelFormat::GRAY: {
+                cv::Mat smallGray{};
+                cv::resize(m_image, smallGray, small, 0, 0, cv::INTER_AREA);
+                cv::cvtColor(smallGray, out, cv::COLOR_GRAY2BGR);
+                break;
+            }
+            default:
+                cv::resize(m_image, out, small, 0, 0, cv::INTER_AREA);
+                break;
+        }
+        m_smallBgr.valid = true;
+        return out;
+    }
+
+    cv::Mat FrameContext::bgrRegion(const cv::Rect& roi){
+        cv::Rect r{ roi & cv::Rect{ cv::Point{}, size() } };
+        if (r.width <= 0 || r.height <= 0) return {};
+
+        // Colour for a luminance-only frame comes from the source, if it can.
+        if (m_format == PixelFormat::GRAY && m_decodeRegion){
+            cv::Mat full{ m_decodeRegion(toFullResolution(r)) };
+            if (full.empty() || full.size() == r.size()) return full;
+            cv::Mat out{};
+            cv::resize(full, out, r.size(), 0, 0, cv::INTER_AREA);
+            return out;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_format == PixelFormat::BGR || m_format == PixelFormat::GRAY || m_bgr.valid) return bgrLocked()(r);
+        return yuvToBgr(r);
+    }
+
+    cv::Mat FrameContext::yuvToBgr(const cv::Rect& roi) const{
+        const cv::Size full{ size() };
+        // Chroma is shared by pixel pairs (and row pairs in NV12), so convert an
+        // even-aligned rectangle and cut the requested one out of it.
+        int x0{ roi.x & ~1 };
+        int y0{ m_format == PixelFormat::NV12 ? (roi.y & ~1) : roi.y };
+        int x1{ std::min(full.width, (roi.x + roi.width + 1) & ~1) };
+        int y1{ m_format == PixelFormat::NV12 ? std::min(full.height, (roi.y + roi.height + 1) & ~1) : roi.y + roi.height };
+        cv::Rect aligned{ x0, y0, x1 - x0, y1 - y0 };
+
+        cv::Mat out{};
+        if (m_format == PixelFormat::YUYV){
+            cv::cvtColor(m_image(aligned), out, cv::COLOR_YUV2BGR_YUYV);
+        }
+        else{
+            // NV12 conversion wants the crop's Y rows followed by its UV rows.
+            cv::Mat packed(aligned.height * 3 / 2, aligned.width, CV_8UC1);
+            m_image(aligned).copyTo(packed.rowRange(0, aligned.height));
+            cv::Rect uvRect{ aligned.x, full.height + aligned.y / 2, aligned.width, aligned.height / 2 };
+            m_image(uvRect).copyTo(packed.rowRange(aligned.height, packed.rows));
+            cv::cvtColor(packed, out, cv::COLOR_YUV2BGR_NV12);
+        }
+
+        cv::Rect inner{ roi.x - x0, roi.y - y0, roi.width, roi.height };
+        return inner == cv::Rect{ 0, 0, out.cols, out.rows } ? out : out(inner);
+    }
+
+    const cv::Mat& FrameContext::mask(QRColour colour, const MaskBuilder& build){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return maskLocked(colour, build);
+    }
+
+    const cv::Mat& FrameContext::maskLocked(QRColour colour, const MaskBuilder& build){
+        Plane& slot{ m_masks[colour] };
+        if (!slot.valid && !m_image.empty()){
+            build(bgrLocked(), colour, slot.mat);
+            slot.valid = true;
+        }
+        return slot.mat;
+    }
+
+    const cv::Mat* FrameContext::cachedMask(QRColour colour){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it{ m_masks.find(colour) };
+        if (it == m_masks.end() || !it->second.valid || it->second.mat.empty()) return nullptr;
+        return &it->second.mat;
+    }
+
+    const cv::Mat& FrameContext::smallMask(QRColour colour, const MaskBuilder& build){
+        if (m_format != PixelFormat::BGR){
+            // Built from the subsampled colour rather than a full-size conversion.
+            const cv::Mat& small{ smallBgr() };
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Plane& slot{ m_smallMasks[colour] };
+            if (!slot.valid && !small.empty()){
+                build(small, colour, slot.mat);
+                slot.valid = true;
+            }
+            return slot.mat;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Plane& slot{ m_smallMasks[colour] };
+        if (!slot.valid){
+            const cv::Mat& full{ maskLocked(colour, build) };
+            if (!full.empty())
+                cv::resize(full, slot.mat, cv::Size(), SMALL_SCALE, SMALL_SCALE, cv::INTER_NEAREST);
+            slot.valid = true;
+        }
+        return slot.mat;
+    }
+
+    const cv::Mat& FrameContext::labels(const LabelBuilder& build){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return labelsLocked(build);
+    }
+
+    const cv::Mat& FrameContext::labelsLocked(const LabelBuilder& build){
+        if (!m_labels.valid && !m_image.empty()){
+            build(bgrLocked(), m_labels.mat);
+            m_labels.valid = true;
+        }
+        return m_labels.mat;
+    }
+
+    const cv::Mat& FrameContext::smallLabels(const LabelBuilder& build){
+        // Same sources as smallMask(), so labels and masks line up.
+        if (m_format != PixelFormat::BGR){
+            const cv::Mat& small{ smallBgr() };
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_smallLabels.valid && !small.empty()){
+                build(small, m_smallLabels.mat);
+                m_smallLabels.valid = true;
+            }
+            return m_smallLabels.mat;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_smallLabels.valid){
+            const cv::Mat& full{ labelsLocked(build) };
+            if (!full.empty())
+                cv::resize(full, m_smallLabels.mat, cv::Size(), SMALL_SCALE, SMALL_SCALE, cv::INTER_NEAREST);
+            m_smallLabels.valid = true;
+        }
+        return m_smallLabels.mat;
+    }
+
+    void FrameContext::setFullResolution(double scale, RegionDecoder decode){
+        m_fullScale = scale;
+        m_decodeRegion = std::move(decode);
+    }
+
+    double FrameContext::fullResolutionScale() const { return m_decodeRegion ? m_fullScale : 1.0; }
+
+    cv::Mat FrameContext::fullResolutionRegion(const cv::Rect& roi){
+        cv::Rect r{ roi & cv::Rect{ cv::Point{}, size() } };
+        if (r.width <= 0 || r.height <= 0) return {};
+
+        // The decoder is fixed before sharing, so it runs without the lock.
+        if (m_decodeRegion && m_fullScale != 1.0) return m_decodeRegion(toFullResolution(r));
+
+        // Codes are read from luminance; don't convert a YUV frame just for this.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_format == PixelFormat::BGR ? m_image(r) : grayLocked()(r);
+    }
+
+    cv::Rect FrameContext::toFullResolution(const cv::Rect& r) const{
+        return cv::Rect{
+            static_cast<int>(r.x * m_fullScale),
+            static_cast<int>(r.y * m_fullScale),
+            static_cast<int>(std::ceil(r.width * m_fullScale)),
+            static_cast<int>(std::ceil(r.height * m_fullScale))
+        };
+    }
+}
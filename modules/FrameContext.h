@@ -0,0 +1,124 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "../utils/QRCode.h"
+
+namespace NavigationVI{
+    // Planes derived from one captured frame, each computed the first time it
+    // is asked for and reused by detection, colour verification and the UI.
+    // Safe to share between the capture/UI thread and the detection thread;
+    // cached planes are never modified once built.
+    //
+    // Frames may arrive as luminance or camera YUV rather than BGR. gray() is
+    // then a view or a single-channel copy, and colour is converted only where
+    // it is asked for: whole-frame via bgr(), at SMALL_SCALE from the
+    // subsampled chroma via smallBgr(), or per crop via bgrRegion().
+    //
+    // A context can be refilled with prepare() for the next frame; plane
+    // buffers are kept and refilled in place (builders included), so a pooled
+    // context's planes stop reallocating once the frame size settles (see
+    // FrameRing).
+    class FrameContext{
+        public:
+            // Builders write into `out`, which holds the plane's buffer from the
+            // last frame, so they should create() rather than assign a new Mat.
+            using MaskBuilder = std::function<void(const cv::Mat& bgr, QRColour colour, cv::Mat& out)>;
+            // One CV_8UC1 image labelling every colour class at once (a bit each).
+            using LabelBuilder = std::function<void(const cv::Mat& bgr, cv::Mat& out)>;
+            // Decodes a region given in full-resolution pixels.
+            using RegionDecoder = std::function<cv::Mat(const cv::Rect& fullResRegion)>;
+
+            // GRAY: CV_8UC1. YUYV: CV_8UC2, Y0 U Y1 V. NV12: CV_8UC1, rows * 3 / 2
+            // high, Y plane followed by interleaved UV.
+            enum class PixelFormat { BGR, GRAY, YUYV, NV12 };
+
+            static constexpr double SMALL_SCALE{ 0.5 };
+
+            using Clock = std::chrono::steady_clock;
+
+            FrameContext() = default;
+            explicit FrameContext(cv::Mat bgr, Clock::time_point captured = Clock::now());
+            FrameContext(cv::Mat image, PixelFormat format, Clock::time_point captured = Clock::now());
+
+            FrameContext(const FrameContext&) = delete;
+            FrameContext& operator=(const FrameContext&) = delete;
+
+            // Starts a new frame: drops every cached plane (keeping its buffer) and
+            // returns the image buffer for the source to fill; commit() then says
+            // what was written. Not thread-safe; only call while no other thread
+            // holds the context.
+            cv::Mat& prepare();
+            void commit(PixelFormat format, Clock::time_point captured);
+            // Refills this context with a copy of `other`'s captured image and time;
+            // no cached planes or full-resolution decoder. Same rules as prepare().
+            void copyFrom(const FrameContext& other);
+            // Scratch bytes a source may keep with the frame (e.g. the compressed JPEG).
+            std::vector<uchar>& encoded();
+
+            PixelFormat format() const;
+            Clock::time_point captureTime() const;
+            cv::Size size() const;
+            bool empty() const;
+
+            const cv::Mat& bgr();
+            const cv::Mat& gray();
+            const cv::Mat& smallBgr();  // SMALL_SCALE
+            const cv::Mat& smallGray();  // SMALL_SCALE, area-averaged
+            // BGR crop; converts only `roi` when the frame isn't BGR already.
+            cv::Mat bgrRegion(const cv::Rect& roi);
+            const cv::Mat& mask(QRColour colour, const MaskBuilder& build);
+            const cv::Mat& smallMask(QRColour colour, const MaskBuilder& build);  // SMALL_SCALE, nearest
+            const cv::Mat* cachedMask(QRColour colour);  // nullptr until mask() has built it
+            // Colour labels from the same plane as mask(), and as smallMask() at
+            // SMALL_SCALE, so per-colour masks can be cut from one pass.
+            const cv::Mat& labels(const LabelBuilder& build);
+            const cv::Mat& smallLabels(const LabelBuilder& build);
+
+            // For sources that deliver frames below sensor resolution: `scale` source
+            // pixels per frame pixel. Set before the context is shared.
+            void setFullResolution(double scale, RegionDecoder decode);
+            double fullResolutionScale() const;
+            // `roi` (in frame coordinates) at full resolution for reading a code:
+            // a view of the BGR or gray plane when the frame already is full size.
+            cv::Mat fullResolutionRegion(const cv::Rect& roi);
+
+        private:
+            // A cached plane; `valid` is cleared per frame so `mat` keeps its buffer.
+            struct Plane{
+                cv::Mat mat{};
+                bool valid{ false };
+            };
+
+            const cv::Mat& bgrLocked();
+            const cv::Mat& grayLocked();
+            const cv::Mat& maskLocked(QRColour colour, const MaskBuilder& build);
+            const cv::Mat& labelsLocked(const LabelBuilder& build);
+            cv::Mat yuvToBgr(const cv::Rect& roi) const;
+            cv::Rect toFullResolution(const cv::Rect& roi) const;
+
+        private:
+            cv::Mat m_image{};
+            PixelFormat m_format{ PixelFormat::BGR };
+            Clock::time_point m_captured{};
+            double m_fullScale{ 1.0 };
+            RegionDecoder m_decodeRegion{};
+            std::vector<uchar> m_encoded{};
+
+            std::mutex m_mutex{};
+            Plane m_bgr{};
+            Plane m_gray{};
+            Plane m_smallBgr{};
+            Plane m_smallGray{};
+            std::map<QRColour, Plane> m_masks{};
+            std::map<QRColour, Plane> m_smallMasks{};
+            Plane m_labels{};
+            Plane m_smallLabels{};
+    };
+}
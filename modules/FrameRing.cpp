@@ -0,0 +1,91 @@
+#include "FrameRing.h"
+
+#include <algorithm>
+
+namespace NavigationVI{
+    FrameRing::FrameRing(){ setConsumers(1); }
+
+    void FrameRing::setConsumers(int consumers){
+        consumers = std::max(1, consumers);
+        m_slots.clear();
+        for (int i{ 0 }; i < consumers + 2; ++i) m_slots.push_back(std::make_unique<FrameContext>());
+        // Slot 0 is the producer's, 1 .. consumers the consumers', the last one "latest".
+        m_consumers.assign(consumers, Consumer{});
+        for (int c{ 0 }; c < consumers; ++c) m_consumers[c].front = c + 1;
+        m_back = 0;
+        m_latest.store(consumers + 1, std::memory_order_release);
+    }
+
+    int FrameRing::consumers() const { return static_cast<int>(m_consumers.size()); }
+
+    FrameContext& FrameRing::writeSlot(){ return *m_slots[m_back]; }
+
+    void FrameRing::publish(){
+        int previous{ m_latest.exchange(m_back | FRESH, std::memory_order_acq_rel) };
+        m_back = previous & INDEX_MASK;
+        m_published.fetch_add(1, std::memory_order_relaxed);
+        if (previous & FRESH) m_dropped.fetch_add(1, std::memory_order_relaxed);
+        m_waitCV.notify_one();
+    }
+
+    void FrameRing::waitUntilTaken(){
+        while (!closed() && (m_latest.load(std::memory_order_acquire) & FRESH)) {
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            m_takenCV.wait_for(lock, std::chrono::milliseconds(5), [this] {
+                return closed() || !(m_latest.load(std::memory_order_acquire) & FRESH);
+            });
+        }
+    }
+
+    FrameContext* FrameRing::tryAcquire(int consumer){
+        Consumer& c{ m_consumers[consumer] };
+        if (!(m_latest.load(std::memory_order_acquire) & FRESH)) return nullptr;
+        int previous{ m_latest.exchange(c.front, std::memory_order_acq_rel) };
+        c.front = previous & INDEX_MASK;
+        // Another consumer got there first; what came back is a free slot.
+        if (!(previous & FRESH)) return nullptr;
+        m_takenCV.notify_one();
+
+        FrameContext& ctx{ *m_slots[c.front] };
+        double latencyMs{ std::chrono::duration<double, std::milli>(FrameContext::Clock::now() - ctx.captureTime()).count() };
+        ++c.consumed;
+        c.latencySumMs += latencyMs;
+        c.maxLatencyMs = std::max(c.maxLatencyMs, latencyMs);
+        return &ctx;
+    }
+
+    FrameContext* FrameRing::acquire(int consumer){
+        while (!closed()) {
+            if (FrameContext* ctx{ tryAcquire(consumer) }) return ctx;
+            // publish() notifies without the mutex, so a wake-up can slip between
+            // the check and the wait; the timeout bounds what that costs.
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            m_waitCV.wait_for(lock, std::chrono::milliseconds(5), [this] {
+                return closed() || (m_latest.load(std::memory_order_acquire) & FRESH);
+            });
+        }
+        return nullptr;
+    }
+
+    void FrameRing::close(){
+        m_closed.store(true, std::memory_order_release);
+        m_waitCV.notify_all();
+        m_takenCV.notify_all();
+    }
+
+    bool FrameRing::closed() const { return m_closed.load(std::memory_order_acquire); }
+
+    FrameRing::Stats FrameRing::getStats() const{
+        Stats s{};
+        s.published = m_published.load(std::memory_order_relaxed);
+        s.dropped = m_dropped.load(std::memory_order_relaxed);
+        double latencySumMs{ 0.0 };
+        for (const auto& c : m_consumers) {
+            s.consumed += c.consumed;
+            latencySumMs += c.latencySumMs;
+            s.maxLatencyMs = std::max(s.maxLatencyMs, c.maxLatencyMs);
+        }
+        s.meanLatencyMs = s.consumed ? latencySumMs / s.consumed : 0.0;
+        return s;
+    }
+}
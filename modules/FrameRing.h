@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "FrameContext.h"
+
+namespace NavigationVI{
+    // Single-producer hand-off where the newest frame wins. consumers + 2
+    // preallocated FrameContexts rotate between the producer (filling), each
+    // consumer (detecting) and a shared "latest" slot that they swap with one
+    // atomic exchange each, so no side ever blocks another and no frame is
+    // allocated or queued. A frame published before any consumer took the
+    // previous one replaces it (counted as dropped).
+    //
+    // With several consumers each holds its own frame until its next acquire,
+    // so that many frames are in flight at once. A consumer that loses the
+    // race for the latest frame simply gets nothing and waits for the next.
+    //
+    // The producer may keep reading the slot it just published (e.g. to draw
+    // the UI) until its next writeSlot(); FrameContext makes that sharing safe.
+    class FrameRing{
+        public:
+            struct Stats{
+                std::uint64_t published{ 0 };
+                std::uint64_t consumed{ 0 };
+                std::uint64_t dropped{ 0 };  // overwritten before the consumer saw them
+                double meanLatencyMs{ 0.0 };  // capture to consumer pickup
+                double maxLatencyMs{ 0.0 };
+            };
+
+            FrameRing();
+
+            // Sets the number of consumers (0 .. consumers-1 below) and reallocates
+            // the slots; only before the ring is in use.
+            void setConsumers(int consumers);
+            int consumers() const;
+
+            // Producer: the slot to fill next, then publish() it.
+            FrameContext& writeSlot();
+            void publish();
+            // Producer: waits until the last published frame has been taken (or
+            // the ring is closed), for sources that must not drop frames.
+            void waitUntilTaken();
+
+            // Consumer: the newest unseen frame, or nullptr if there is none yet.
+            // The slot `consumer` acquired before goes back to the producer.
+            FrameContext* tryAcquire(int consumer = 0);
+            // Waits for one; nullptr once close() has been called.
+            FrameContext* acquire(int consumer = 0);
+
+            void close();
+            bool closed() const;
+
+            // Consumer-side counters; read after the consumers have stopped.
+            Stats getStats() const;
+
+        private:
+            static constexpr int FRESH{ 1 << 16 };  // set on m_latest by publish, cleared by acquire
+            static constexpr int INDEX_MASK{ FRESH - 1 };
+
+            // One per consumer, on its own cache line; only that consumer touches it.
+            struct alignas(64) Consumer{
+                int front{ 0 };
+                std::uint64_t consumed{ 0 };
+                double latencySumMs{ 0.0 };
+                double maxLatencyMs{ 0.0 };
+            };
+
+            std::vector<std::unique_ptr<FrameContext>> m_slots{};
+            std::vector<Consumer> m_consumers{};
+            int m_back{ 0 };   // producer only
+            std::atomic<int> m_latest{ 0 };
+            std::atomic<bool> m_closed{ false };
+
+            // Only for sleeping when there is nothing to take (or, for the
+            // producer, nothing taken); the hand-off itself is lock-free.
+            std::mutex m_waitMutex{};
+            std::condition_variable m_waitCV{};
+            std::condition_variable m_takenCV{};
+
+            std::atomic<std::uint64_t> m_published{ 0 };
+            std::atomic<std::uint64_t> m_dropped{ 0 };
+    };
+}
@@ -0,0 +1,83 @@
+#include "FrameSource.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+
+namespace NavigationVI{
+    std::shared_ptr<FrameContext> FrameSource::read(){
+        auto ctx{ std::make_shared<FrameContext>() };
+        if (!readInto(*ctx)) return nullptr;
+        return ctx;
+    }
+
+    VideoCaptureSource::VideoCaptureSource(int cameraIndex)
+        : m_capture(cameraIndex) {}
+
+    VideoCaptureSource::VideoCaptureSource(const std::string& pipelineOrPath, int apiPreference)
+        : m_capture(pipelineOrPath, apiPreference) {}
+
+    bool VideoCaptureSource::isOpened() const { return m_capture.isOpened(); }
+
+    bool VideoCaptureSource::readInto(FrameContext& ctx){
+        cv::Mat& image{ ctx.prepare() };
+        if (!m_capture.read(image) || image.empty()) return false;
+        ctx.commit(FrameContext::PixelFormat::BGR, FrameContext::Clock::now());
+        return true;
+    }
+
+    double VideoCaptureSource::frameRate() const { return m_capture.get(cv::CAP_PROP_FPS); }
+
+    ImageSequenceSource::ImageSequenceSource(const std::string& directory){
+        std::error_code ec{};
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec)){
+            if (!entry.is_regular_file()) continue;
+            std::string ext{ entry.path().extension().string() };
+            std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c){ return std::tolower(c); });
+            if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp")
+                m_files.push_back(entry.path().string());
+        }
+        if (ec) std::cerr << "Failed to list " << directory << ": " << ec.message() << "\n";
+        std::sort(m_files.begin(), m_files.end());
+    }
+
+    bool ImageSequenceSource::isOpened() const { return !m_files.empty(); }
+
+    bool ImageSequenceSource::readInto(FrameContext& ctx){
+        if (m_next >= m_files.size()) return false;
+        cv::Mat image{ cv::imread(m_files[m_next++], cv::IMREAD_COLOR) };
+        if (image.empty()){
+            std::cerr << "Failed to read " << m_files[m_next - 1] << "\n";
+            return false;
+        }
+        image.copyTo(ctx.prepare());
+        ctx.commit(FrameContext::PixelFormat::BGR, FrameContext::Clock::now());
+        return true;
+    }
+
+    YuvCaptureSource::YuvCaptureSource(const std::string& pipeline)
+        : m_capture(pipeline, cv::CAP_GSTREAMER) {
+        m_capture.set(cv::CAP_PROP_CONVERT_RGB, 0);
+    }
+
+    bool YuvCaptureSource::isOpened() const { return m_capture.isOpened(); }
+
+    bool YuvCaptureSource::readInto(FrameContext& ctx){
+        cv::Mat& image{ ctx.prepare() };
+        if (!m_capture.read(image) || image.empty()) return false;
+        auto captured{ FrameContext::Clock::now() };
+
+        // YUY2 arrives as two channels per pixel, NV12 as one plane 3/2 high.
+        FrameContext::PixelFormat format{};
+        if (image.type() == CV_8UC2) format = FrameContext::PixelFormat::YUYV;
+        else if (image.type() == CV_8UC1 && image.rows % 3 == 0) format = FrameContext::PixelFormat::NV12;
+        else if (image.type() == CV_8UC3) format = FrameContext::PixelFormat::BGR;
+        else{
+            std::cerr << "Unsupported YUV frame layout\n";
+            return false;
+        }
+        ctx.commit(format, captured);
+        return true;
+    }
+}
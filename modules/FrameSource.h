@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "FrameContext.h"
+
+namespace NavigationVI{
+    // Where frames come from. A source may deliver frames smaller than the
+    // sensor resolution (see downscale()); the FrameContext it fills can
+    // still produce full-resolution crops for decoding.
+    class FrameSource{
+        public:
+            virtual ~FrameSource() = default;
+
+            virtual bool isOpened() const = 0;
+            // Refills `ctx` (FrameContext::prepare/commit) with the next frame,
+            // reusing its buffers. False at the end of the stream or on a read error.
+            virtual bool readInto(FrameContext& ctx) = 0;
+            // Next frame in a context of its own, or nullptr.
+            std::shared_ptr<FrameContext> read();
+            // Source pixels per delivered pixel (1 = full resolution).
+            virtual double downscale() const { return 1.0; }
+            // Nominal frames per second of a recording; 0 when unknown or live.
+            virtual double frameRate() const { return 0.0; }
+            // Frames that arrived but couldn't be decoded and were skipped.
+            virtual std::size_t corruptFrames() const { return 0; }
+            // Only luminance is needed (no target colour): sources that can skip
+            // colour conversion do.
+            virtual void setLumaOnly(bool lumaOnly) { (void)lumaOnly; }
+    };
+
+    // Decoded BGR frames from cv::VideoCapture: a camera index, a file, or a
+    // GStreamer pipeline ending in a BGR appsink.
+    class VideoCaptureSource : public FrameSource{
+        public:
+            explicit VideoCaptureSource(int cameraIndex);
+            VideoCaptureSource(const std::string& pipelineOrPath, int apiPreference = cv::CAP_ANY);
+
+            bool isOpened() const override;
+            bool readInto(FrameContext& ctx) override;
+            double frameRate() const override;
+
+        private:
+            cv::VideoCapture m_capture{};
+    };
+
+    // Still images from a directory (png, jpg, jpeg, bmp), in file name order.
+    class ImageSequenceSource : public FrameSource{
+        public:
+            explicit ImageSequenceSource(const std::string& directory);
+
+            bool isOpened() const override;
+            bool readInto(FrameContext& ctx) override;
+
+        private:
+            std::vector<std::string> m_files{};
+            std::size_t m_next{ 0 };
+    };
+
+    // Raw camera YUV (YUYV or NV12) from a GStreamer pipeline ending in
+    // "video/x-raw,format=YUY2 ! appsink" or "format=NV12". Frames keep the
+    // camera layout, so detection reads the Y plane directly and colour is
+    // converted only where it is used.
+    class YuvCaptureSource : public FrameSource{
+        public:
+            explicit YuvCaptureSource(const std::string& pipeline);
+
+            bool isOpened() const override;
+            bool readInto(FrameContext& ctx) override;
+
+        private:
+            cv::VideoCapture m_capture{};
+    };
+}
@@ -0,0 +1,105 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace NavigationVI{
+    void LatencyHistogram::record(double ms){
+        std::uint64_t us{ static_cast<std::uint64_t>(std::max(0.0, ms) * 1000.0 + 0.5) };
+        m_counts[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sumUs.fetch_add(us, std::memory_order_relaxed);
+
+        std::uint64_t prev{ m_maxUs.load(std::memory_order_relaxed) };
+        while (us > prev && !m_maxUs.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {}
+    }
+
+    std::uint64_t LatencyHistogram::count() const { return m_count.load(std::memory_order_relaxed); }
+
+    double LatencyHistogram::meanMs() const{
+        std::uint64_t n{ count() };
+        return n ? m_sumUs.load(std::memory_order_relaxed) / 1000.0 / n : 0.0;
+    }
+
+    double LatencyHistogram::maxMs() const { return m_maxUs.load(std::memory_order_relaxed) / 1000.0; }
+
+    double LatencyHistogram::percentileMs(double p) const{
+        // Buckets are read one by one while others may still be recording, so
+        // the total is taken from the same snapshot.
+        std::array<std::uint64_t, BUCKETS> snapshot{};
+        std::uint64_t total{ 0 };
+        for (std::size_t i{ 0 }; i < BUCKETS; ++i){
+            snapshot[i] = m_counts[i].load(std::memory_order_relaxed);
+            total += snapshot[i];
+        }
+        if (total == 0) return 0.0;
+
+        std::uint64_t rank{ static_cast<std::uint64_t>(std::ceil(std::clamp(p, 0.0, 1.0) * total)) };
+        rank = std::max<std::uint64_t>(rank, 1);
+        std::uint64_t seen{ 0 };
+        for (std::size_t i{ 0 }; i < BUCKETS; ++i){
+            seen += snapshot[i];
+            if (seen >= rank) return std::min(bucketMidUs(i) / 1000.0, maxMs());
+        }
+        return maxMs();
+    }
+
+    std::size_t LatencyHistogram::bucketFor(std::uint64_t us){
+        // Below 2 * SUB_BUCKETS every microsecond has its own bucket; above,
+        // the top SUB_BITS + 1 bits pick the bucket within the power of two.
+        if (us < SUB_BUCKETS) return static_cast<std::size_t>(us);
+        us = std::min<std::uint64_t>(us, (std::uint64_t{ 1 } << (MAX_EXPONENT + 1)) - 1);
+        int exponent{ SUB_BITS };
+        while ((us >> (exponent + 1)) != 0) ++exponent;
+        std::uint64_t sub{ us >> (exponent - SUB_BITS) };
+        return static_cast<std::size_t>((exponent - SUB_BITS + 1) * SUB_BUCKETS + (sub - SUB_BUCKETS));
+    }
+
+    double LatencyHistogram::bucketMidUs(std::size_t bucket){
+        if (bucket < 2 * SUB_BUCKETS) return static_cast<double>(bucket);
+        std::size_t group{ bucket / SUB_BUCKETS };
+        std::uint64_t sub{ bucket % SUB_BUCKETS };
+        std::uint64_t width{ std::uint64_t{ 1 } << (group - 1) };
+        return static_cast<double>((SUB_BUCKETS + sub) * width) + width * 0.5;
+    }
+
+    LatencyHistogram& latencyHistogram(LatencyStage stage){
+        static std::array<LatencyHistogram, static_cast<std::size_t>(LatencyStage::COUNT)> histograms{};
+        return histograms[static_cast<std::size_t>(stage)];
+    }
+
+    const char* latencyStageName(LatencyStage stage){
+        switch (stage){
+            case LatencyStage::Capture: return "capture";
+            case LatencyStage::ColourMask: return "colour mask";
+            case LatencyStage::CandidateRois: return "candidate ROIs";
+            case LatencyStage::RobustDetect: return "robust detect";
+            case LatencyStage::ExtractRoi: return "extract ROI";
+            case LatencyStage::Decode: return "decode";
+            case LatencyStage::RoutePlan: return "route plan";
+            case LatencyStage::Speech: return "speech";
+            case LatencyStage::EndToEnd: return "visible-to-spoken";
+            default: return "?";
+        }
+    }
+
+    void writeLatencyReport(std::ostream& out){
+        std::ios flags{ nullptr };
+        flags.copyfmt(out);
+        out << std::left << std::setw(20) << "stage" << std::right
+            << std::setw(10) << "count" << std::setw(10) << "mean"
+            << std::setw(10) << "p50" << std::setw(10) << "p95"
+            << std::setw(10) << "p99" << std::setw(10) << "max" << "  (ms)\n";
+        out << std::fixed << std::setprecision(2);
+        for (std::size_t s{ 0 }; s < static_cast<std::size_t>(LatencyStage::COUNT); ++s){
+            auto stage{ static_cast<LatencyStage>(s) };
+            const LatencyHistogram& h{ latencyHistogram(stage) };
+            out << std::left << std::setw(20) << latencyStageName(stage) << std::right
+                << std::setw(10) << h.count() << std::setw(10) << h.meanMs()
+                << std::setw(10) << h.percentileMs(0.50) << std::setw(10) << h.percentileMs(0.95)
+                << std::setw(10) << h.percentileMs(0.99) << std::setw(10) << h.maxMs() << "\n";
+        }
+        out.copyfmt(flags);
+    }
+}
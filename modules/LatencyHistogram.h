@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace NavigationVI{
+    // Pipeline stages that are timed. EndToEnd runs from the first frame a code
+    // was seen in to the start of the instruction spoken for it.
+    enum class LatencyStage{
+        Capture,
+        ColourMask,
+        CandidateRois,
+        RobustDetect,
+        ExtractRoi,
+        Decode,
+        RoutePlan,
+        Speech,
+        EndToEnd,
+        COUNT
+    };
+
+    // Durations in microseconds, bucketed log-linearly: each power of two is
+    // split into SUB_BUCKETS equal buckets, so a percentile is within about
+    // 1/SUB_BUCKETS of the true value. Recording is a few relaxed atomic adds,
+    // safe from any thread without a lock.
+    class LatencyHistogram{
+        public:
+            void record(double ms);
+
+            std::uint64_t count() const;
+            double meanMs() const;
+            double maxMs() const;
+            // `p` in [0, 1]; 0 with no samples.
+            double percentileMs(double p) const;
+
+        private:
+            static std::size_t bucketFor(std::uint64_t us);
+            static double bucketMidUs(std::size_t bucket);
+
+        private:
+            static constexpr int SUB_BITS{ 4 };
+            static constexpr std::uint64_t SUB_BUCKETS{ 1u << SUB_BITS };
+            static constexpr int MAX_EXPONENT{ 36 };  // 2^37 us, about 38 hours
+            static constexpr std::size_t BUCKETS{ (MAX_EXPONENT - SUB_BITS + 2) * SUB_BUCKETS };
+
+            std::array<std::atomic<std::uint64_t>, BUCKETS> m_counts{};
+            std::atomic<std::uint64_t> m_count{ 0 };
+            std::atomic<std::uint64_t> m_sumUs{ 0 };
+            std::atomic<std::uint64_t> m_maxUs{ 0 };
+    };
+
+    // Process-wide histogram for `stage`.
+    LatencyHistogram& latencyHistogram(LatencyStage stage);
+    const char* latencyStageName(LatencyStage stage);
+    // count, mean, p50/p95/p99 and max per stage, in ms.
+    void writeLatencyReport(std::ostream& out);
+
+    // Records the time from construction to destruction against a stage.
+    class ScopedLatency{
+        public:
+            explicit ScopedLatency(LatencyStage stage)
+                : m_stage(stage), m_start(std::chrono::steady_clock::now()) {}
+            ~ScopedLatency(){
+                std::chrono::duration<double, std::milli> elapsed{ std::chrono::steady_clock::now() - m_start };
+                latencyHistogram(m_stage).record(elapsed.count());
+            }
+
+            ScopedLatency(const ScopedLatency&) = delete;
+            ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+        private:
+            LatencyStage m_stage;
+            std::chrono::steady_clock::time_point m_start;
+    };
+}
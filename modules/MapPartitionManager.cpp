@@ -0,0 +1,396 @@
+#include "MapPartitionManager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <sstream>
+
+namespace NavigationVI{
+    MapPartitionManager::MapPartitionManager(CoordinateMapSystem& map)
+        : m_map(map) {}
+
+    std::string MapPartitionManager::toLower(std::string s){
+        std::transform(s.begin(), s.end(), s.begin(),
+            [](unsigned char c){ return std::tolower(c); });
+        return s;
+    }
+
+    bool MapPartitionManager::loadManifest(const std::string& filePath){
+        if (m_map.isStaticMap()){
+            std::cerr << "MapPartitionManager: map is embedded, partitions are not supported\n";
+            return false;
+        }
+
+        std::ifstream file(filePath);
+        if (!file.is_open()) return false;
+
+        std::string line{};
+        while (std::getline(file, line)){
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+
+            std::stringstream ss(line);
+            std::string kind{};
+            std::getline(ss, kind, '|');
+
+            if (kind == "BOUNDARY"){
+                std::string roomsFile{}, connectionsFile{};
+                std::getline(ss, roomsFile, '|');
+                std::getline(ss, connectionsFile, '|');
+
+                std::vector<Room> rooms{};
+                std::vector<ConnectionRecord> connections{};
+                if (!CoordinateMapSystem::readRoomsFile(roomsFile, rooms) ||
+                    !CoordinateMapSystem::readConnectionsFile(connectionsFile, connections)){
+                    std::cerr << "MapPartitionManager: failed to read boundary graph\n";
+                    return false;
+                }
+                for (const auto& r : rooms){
+                    m_boundaryRooms.insert(r.m_id);
+                    m_roomNames[r.m_id] = r.m_name;
+                    m_nameIndex.emplace(toLower(r.m_name), r.m_id);
+                    m_map.addRoom(r);
+                }
+                for (const auto& c : connections){
+                    m_map.addConnectionBetween(c.fromRoom, c.toRoom, c.pathwayType);
+                    m_boundaryLinks[c.fromRoom].push_back(c.toRoom);
+                    m_boundaryLinks[c.toRoom].push_back(c.fromRoom);
+                }
+                m_map.rebuildComponents();
+                m_map.rebuildTurnTable();
+            } else if (kind == "PARTITION"){
+                Partition p{};
+                std::getline(ss, p.id, '|');
+                std::getline(ss, p.roomsFile, '|');
+                std::getline(ss, p.connectionsFile, '|');
+                if (p.id.empty()) continue;
+                if (!indexPartition(p)){
+                    std::cerr << "MapPartitionManager: skipping partition " << p.id << "\n";
+                    continue;
+                }
+                std::string id{ p.id };
+                m_partitions.emplace(id, std::move(p));
+            }
+        }
+
+        m_loaded = !m_partitions.empty();
+        return m_loaded;
+    }
+
+    bool MapPartitionManager::indexPartition(Partition& p){
+        std::vector<Room> rooms{};
+        std::vector<ConnectionRecord> connections{};
+        if (!CoordinateMapSystem::readRoomsFile(p.roomsFile, rooms) ||
+            !CoordinateMapSystem::readConnectionsFile(p.connectionsFile, connections)) return false;
+
+        std::unordered_set<std::string> own{};
+        p.roomIds.reserve(rooms.size());
+        for (const auto& r : rooms){
+            p.roomIds.push_back(r.m_id);
+            own.insert(r.m_id);
+            m_roomPartition.emplace(r.m_id, p.id);
+            m_roomNames.emplace(r.m_id, r.m_name);
+            m_nameIndex.emplace(toLower(r.m_name), r.m_id);
+        }
+
+        // Only the links leaving the partition are kept; they are the edges of the
+        // partition-level graph partitionSequence() searches.
+        std::unordered_set<std::string> portals{};
+        for (const auto& c : connections){
+            for (const auto* end : { &c.fromRoom, &c.toRoom }){
+                if (own.count(*end)) continue;
+                // Boundary rooms are only known once the whole manifest is read, so
+                // any link leaving the partition is kept; merges sort them out.
+                p.crossLinks.push_back(c);
+                if (!portals.insert(*end).second) continue;
+                p.portals.push_back(*end);
+                m_portalPartitions[*end].push_back(p.id);
+            }
+        }
+        return true;
+    }
+
+    bool MapPartitionManager::isLoaded() const { return m_loaded; }
+
+    void MapPartitionManager::setMapMutex(std::mutex* mutex) { m_mapMutex = mutex; }
+    void MapPartitionManager::setChangeCallback(std::function<void()> onChange) { m_onChange = std::move(onChange); }
+
+    std::unique_lock<std::mutex> MapPartitionManager::lockMap() const{
+        return m_mapMutex ? std::unique_lock<std::mutex>(*m_mapMutex) : std::unique_lock<std::mutex>{};
+    }
+
+    void MapPartitionManager::notifyChanged() const{
+        if (m_onChange) m_onChange();
+    }
+
+    void MapPartitionManager::setMemoryBudget(std::size_t bytes){
+        m_budgetBytes = bytes;
+        makeRoom(0, m_pinned);
+    }
+    std::size_t MapPartitionManager::getMemoryBudget() const { return m_budgetBytes; }
+    std::size_t MapPartitionManager::residentBytes() const { return m_residentBytes; }
+
+    std::vector<std::string> MapPartitionManager::residentPartitions() const{
+        return std::vector<std::string>(m_lru.begin(), m_lru.end());
+    }
+
+    std::optional<std::string> MapPartitionManager::resolveRoomId(const std::string& ident) const{
+        if (m_roomNames.count(ident)) return ident;
+        auto it{ m_nameIndex.find(toLower(ident)) };
+        if (it != m_nameIndex.end()) return it->second;
+        return std::nullopt;
+    }
+
+    std::optional<std::string> MapPartitionManager::roomName(const std::string& roomId) const{
+        auto it{ m_roomNames.find(roomId) };
+        if (it == m_roomNames.end()) return std::nullopt;
+        return it->second;
+    }
+
+    std::optional<std::string> MapPartitionManager::partitionOf(const std::string& roomId) const{
+        auto it{ m_roomPartition.find(roomId) };
+        if (it == m_roomPartition.end()) return std::nullopt;
+        return it->second;
+    }
+
+    MapPartitionManager::PartitionData MapPartitionManager::readPartition(
+        const std::string& roomsFile,
+        const std::string& connectionsFile){
+        PartitionData data{};
+        data.ok = CoordinateMapSystem::readRoomsFile(roomsFile, data.rooms) &&
+                  CoordinateMapSystem::readConnectionsFile(connectionsFile, data.connections);
+        return data;
+    }
+
+    std::size_t MapPartitionManager::estimateBytes(const PartitionData& data){
+        // Rough resident cost: the Room itself, its strings, and both directions of
+        // each connection in m_connections plus the neighbour-set entries.
+        std::size_t bytes{ 0 };
+        for (const auto& r : data.rooms)
+            bytes += sizeof(Room) + r.m_id.capacity() + r.m_name.capacity() + 64;
+        for (const auto& c : data.connections)
+            bytes += 2 * (sizeof(Connection) + c.fromRoom.capacity() + c.toRoom.capacity() + 64);
+        return bytes;
+    }
+
+    void MapPartitionManager::touch(Partition& p){
+        m_lru.erase(p.lruPos);
+        m_lru.push_front(p.id);
+        p.lruPos = m_lru.begin();
+    }
+
+    void MapPartitionManager::evictPartition(Partition& p){
+        if (!p.resident) return;
+        {
+            auto lock{ lockMap() };
+            for (const auto& id : p.roomIds){
+                if (!m_boundaryRooms.count(id)) m_map.removeRoom(id);
+            }
+            m_map.rebuildComponents();
+            m_map.rebuildTurnTable();
+        }
+        m_lru.erase(p.lruPos);
+        m_residentBytes -= std::min(m_residentBytes, p.bytes);
+        p.resident = false;
+        p.bytes = 0;
+        notifyChanged();
+    }
+
+    void MapPartitionManager::makeRoom(std::size_t incomingBytes, const std::unordered_set<std::string>& pinned){
+        auto it{ m_lru.end() };
+        while (m_residentBytes + incomingBytes > m_budgetBytes && it != m_lru.begin()){
+            --it;
+            if (pinned.count(*it)) continue;
+            Partition& victim{ m_partitions.at(*it) };
+            it = std::next(it);
+            evictPartition(victim);
+        }
+        if (m_residentBytes + incomingBytes > m_budgetBytes)
+            std::cerr << "MapPartitionManager: pinned partitions exceed the memory budget\n";
+    }
+
+    void MapPartitionManager::mergePartition(Partition& p, PartitionData data){
+        if (!data.ok){
+            std::cerr << "MapPartitionManager: failed to read partition " << p.id << "\n";
+            return;
+        }
+
+        std::size_t bytes{ estimateBytes(data) };
+        makeRoom(bytes, m_pinned);
+
+        {
+            auto lock{ lockMap() };
+            for (const auto& r : data.rooms) m_map.addRoom(r);
+            for (const auto& c : data.connections){
+                if (m_map.addConnectionBetween(c.fromRoom, c.toRoom, c.pathwayType)) continue;
+                // A link into a partition that isn't loaded is added when it is (below).
+                if (m_roomPartition.count(c.fromRoom) && m_roomPartition.count(c.toRoom)) continue;
+                std::cerr << "MapPartitionManager: " << p.id << " connects to unknown room "
+                          << c.fromRoom << "|" << c.toRoom << "\n";
+            }
+            // Links into this partition live in the other partitions' files; those
+            // loaded first couldn't add them, and evicting this one dropped them.
+            for (const auto& [id, other] : m_partitions){
+                if (!other.resident || id == p.id) continue;
+                for (const auto& c : other.crossLinks){
+                    auto from{ partitionOf(c.fromRoom) };
+                    auto to{ partitionOf(c.toRoom) };
+                    if ((from && *from == p.id) || (to && *to == p.id))
+                        m_map.addConnectionBetween(c.fromRoom, c.toRoom, c.pathwayType);
+                }
+            }
+            m_map.rebuildComponents();
+            m_map.rebuildTurnTable();
+        }
+
+        p.resident = true;
+        p.bytes = bytes;
+        m_residentBytes += bytes;
+        m_lru.push_front(p.id);
+        p.lruPos = m_lru.begin();
+        notifyChanged();
+    }
+
+    void MapPartitionManager::collectReadyPrefetches(){
+        for (auto& [id, p] : m_partitions){
+            if (!p.pending.valid()) continue;
+            if (p.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+            PartitionData data{ p.pending.get() };
+            if (!p.resident) mergePartition(p, std::move(data));
+        }
+    }
+
+    bool MapPartitionManager::ensureLoaded(const std::string& partitionId){
+        auto it{ m_partitions.find(partitionId) };
+        if (it == m_partitions.end()) return false;
+        Partition& p{ it->second };
+
+        if (p.resident){
+            touch(p);
+            return true;
+        }
+
+        PartitionData data{ p.pending.valid() ? p.pending.get() : readPartition(p.roomsFile, p.connectionsFile) };
+        mergePartition(p, std::move(data));
+        return p.resident;
+    }
+
+    void MapPartitionManager::prefetchAsync(const std::string& partitionId){
+        auto it{ m_partitions.find(partitionId) };
+        if (it == m_partitions.end()) return;
+        Partition& p{ it->second };
+        if (p.resident || p.pending.valid()) return;
+
+        // Only file parsing runs off-thread; the map is mutated on the next
+        // ensureLoaded / prepareRoute call from the owning thread.
+        p.pending = std::async(std::launch::async, &MapPartitionManager::readPartition,
+                               p.roomsFile, p.connectionsFile);
+    }
+
+    std::optional<std::vector<std::string>> MapPartitionManager::partitionSequence(
+        const std::string& startId,
+        const std::string& goalId) const{
+        // Breadth-first over partitions and boundary rooms: a partition's neighbours
+        // are the rooms its connections file links to and the partitions whose files
+        // link to its rooms, a boundary room's are the
+        // boundary rooms it connects to and the partitions that link to it. Fewest
+        // hops is a good enough proxy here; A* picks the actual path afterwards.
+        struct Node{
+            bool partition{ false };
+            std::string id{};
+        };
+        auto key = [](const Node& n){ return (n.partition ? "P|" : "R|") + n.id; };
+        auto nodeOf = [this](const std::string& roomId){
+            auto part{ partitionOf(roomId) };
+            return part ? Node{ true, *part } : Node{ false, roomId };
+        };
+
+        const Node start{ nodeOf(startId) };
+        const Node goal{ nodeOf(goalId) };
+        const std::string goalKey{ key(goal) };
+
+        std::unordered_map<std::string, Node> parent{};
+        std::queue<Node> open{};
+        parent.emplace(key(start), start);
+        open.push(start);
+
+        bool found{ false };
+        while (!open.empty()){
+            Node cur{ open.front() };
+            open.pop();
+            if (key(cur) == goalKey){
+                found = true;
+                break;
+            }
+
+            std::vector<Node> next{};
+            if (cur.partition){
+                const Partition& part{ m_partitions.at(cur.id) };
+                for (const auto& r : part.portals){
+                    if (m_boundaryRooms.count(r) || m_roomPartition.count(r)) next.push_back(nodeOf(r));
+                }
+                // A link between two partitions is listed in only one of their files.
+                for (const auto& r : part.roomIds){
+                    auto it{ m_portalPartitions.find(r) };
+                    if (it == m_portalPartitions.end()) continue;
+                    for (const auto& other : it->second) next.push_back(Node{ true, other });
+                }
+            } else {
+                if (auto it{ m_boundaryLinks.find(cur.id) }; it != m_boundaryLinks.end()){
+                    for (const auto& r : it->second) next.push_back(nodeOf(r));
+                }
+                if (auto it{ m_portalPartitions.find(cur.id) }; it != m_portalPartitions.end()){
+                    for (const auto& part : it->second) next.push_back(Node{ true, part });
+                }
+            }
+            for (auto& n : next){
+                if (parent.emplace(key(n), cur).second) open.push(std::move(n));
+            }
+        }
+        if (!found) return std::nullopt;
+
+        std::vector<std::string> sequence{};
+        const std::string startKey{ key(start) };
+        for (Node cur{ goal };; cur = parent.at(key(cur))){
+            if (cur.partition) sequence.push_back(cur.id);
+            if (key(cur) == startKey) break;
+        }
+        std::reverse(sequence.begin(), sequence.end());
+        return sequence;
+    }
+
+    bool MapPartitionManager::prepareRoute(const std::string& startRoom, const std::string& goalRoom){
+        collectReadyPrefetches();
+
+        auto startId{ resolveRoomId(startRoom) };
+        auto goalId{ resolveRoomId(goalRoom) };
+        if (!startId || !goalId) return false;
+
+        auto sequence{ partitionSequence(*startId, *goalId) };
+        if (!sequence){
+            std::cerr << "MapPartitionManager: no partition route from " << *startId << " to " << *goalId << "\n";
+            return false;
+        }
+
+        // Everything on the sequence is pinned so loading one partition never evicts
+        // another the route needs. The rest start parsing in the background while the
+        // start partition is read here; each is then merged in route order.
+        m_pinned = std::unordered_set<std::string>(sequence->begin(), sequence->end());
+        for (std::size_t i{ 1 }; i < sequence->size(); ++i) prefetchAsync((*sequence)[i]);
+
+        bool loaded{ true };
+        for (const auto& id : *sequence){
+            if (!ensureLoaded(id)){
+                loaded = false;
+                break;
+            }
+        }
+        m_pinned.clear();
+        if (!loaded)
+            std::cerr << "MapPartitionManager: could not load every partition between "
+                      << *startId << " and " << *goalId << "\n";
+        return loaded;
+    }
+}
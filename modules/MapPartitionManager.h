@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../utils/MapEntities.h"
+#include "../utils/RouteTypes.h"
+#include "CoordinateMapSystem.h"
+
+namespace NavigationVI{
+    // Loads a campus map one partition (building/floor) at a time into a
+    // CoordinateMapSystem. The boundary graph — rooms and connections that link
+    // partitions — stays resident; partitions are loaded when a route needs them
+    // and evicted least-recently-used once the memory budget is exceeded.
+    //
+    // Manifest format (one entry per line, '#' comments):
+    //   BOUNDARY|<rooms file>|<connections file>
+    //   PARTITION|<id>|<rooms file>|<connections file>
+    //
+    // The boundary connections file links boundary rooms to each other; links from
+    // a partition's rooms to boundary rooms belong in that partition's file.
+    //
+    // Not thread-safe: call from the thread that owns the map. That thread reads
+    // the map freely; merges and evictions take the mutex passed to setMapMutex so
+    // other threads can read under it, and the change callback runs after each.
+    class MapPartitionManager{
+        public:
+            explicit MapPartitionManager(CoordinateMapSystem& map);
+
+            bool loadManifest(const std::string& filePath);
+            bool isLoaded() const;
+
+            void setMapMutex(std::mutex* mutex);
+            void setChangeCallback(std::function<void()> onChange);
+
+            void setMemoryBudget(std::size_t bytes);
+            std::size_t getMemoryBudget() const;
+            std::size_t residentBytes() const;
+            std::vector<std::string> residentPartitions() const;
+
+            std::optional<std::string> resolveRoomId(const std::string& ident) const;
+            std::optional<std::string> roomName(const std::string& roomId) const;
+            std::optional<std::string> partitionOf(const std::string& roomId) const;
+
+            bool ensureLoaded(const std::string& partitionId);
+            void prefetchAsync(const std::string& partitionId);
+
+            // Finds the partitions a route crosses on the boundary graph and makes them
+            // all resident, so A* (run by the caller) sees every partition the route
+            // passes through. Files past the start are parsed in the background while
+            // the start is read, but the call still waits for every partition; only the
+            // parsing overlaps. False when the rooms are unknown, the boundary graph
+            // doesn't connect them or a partition failed to load.
+            bool prepareRoute(const std::string& startRoom, const std::string& goalRoom);
+
+            // Partitions crossed between two rooms, in order (start and goal included),
+            // or nullopt when the boundary graph doesn't connect them.
+            std::optional<std::vector<std::string>> partitionSequence(const std::string& startId,
+                                                                      const std::string& goalId) const;
+
+        private:
+            struct PartitionData{
+                std::vector<Room> rooms{};
+                std::vector<ConnectionRecord> connections{};
+                bool ok{ false };
+            };
+
+            struct Partition{
+                std::string id{};
+                std::string roomsFile{};
+                std::string connectionsFile{};
+                bool resident{ false };
+                std::size_t bytes{ 0 };
+                std::vector<std::string> roomIds{};
+                std::vector<std::string> portals{};  // rooms outside this partition it links to
+                std::vector<ConnectionRecord> crossLinks{};  // its links into other partitions
+                std::list<std::string>::iterator lruPos{};
+                std::future<PartitionData> pending{};
+            };
+
+            static PartitionData readPartition(const std::string& roomsFile, const std::string& connectionsFile);
+            static std::size_t estimateBytes(const PartitionData& data);
+            static std::string toLower(std::string s);
+
+            bool indexPartition(Partition& p);
+            void mergePartition(Partition& p, PartitionData data);
+            void evictPartition(Partition& p);
+            void makeRoom(std::size_t incomingBytes, const std::unordered_set<std::string>& pinned);
+            void touch(Partition& p);
+            void collectReadyPrefetches();
+            std::unique_lock<std::mutex> lockMap() const;
+            void notifyChanged() const;
+
+        private:
+            CoordinateMapSystem& m_map;
+            std::mutex* m_mapMutex{ nullptr };
+            std::function<void()> m_onChange{};
+            std::size_t m_budgetBytes{ 8 * 1024 * 1024 };
+            std::size_t m_residentBytes{ 0 };
+            bool m_loaded{ false };
+
+            std::unordered_map<std::string, Partition> m_partitions{};
+            std::list<std::string> m_lru{};  // front = most recently used
+
+            std::unordered_set<std::string> m_boundaryRooms{};
+            std::unordered_map<std::string, std::vector<std::string>> m_boundaryLinks{};
+            std::unordered_map<std::string, std::vector<std::string>> m_portalPartitions{};  // room -> partitions linking to it
+            std::unordered_map<std::string, std::string> m_roomPartition{};
+            std::unordered_map<std::string, std::string> m_roomNames{};
+            std::unordered_map<std::string, std::string> m_nameIndex{};  // lower-case name -> id
+            std::unordered_set<std::string> m_pinned{};
+    };
+}
@@ -0,0 +1,211 @@
+#include "MjpegSource.h"
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <iostream>
+
+#include <jpeglib.h>
+
+namespace NavigationVI{
+    namespace{
+        // libjpeg's default error handler exits the process; jump back instead.
+        struct JpegErrorManager{
+            jpeg_error_mgr pub{};
+            std::jmp_buf jump{};
+        };
+
+        void onJpegError(j_common_ptr cinfo){
+            auto* err{ reinterpret_cast<JpegErrorManager*>(cinfo->err) };
+            std::longjmp(err->jump, 1);
+        }
+
+        // Everything libjpeg can longjmp out of runs in this frame, which holds
+        // only plain libjpeg state: a jump must not skip a destructor. The Mats
+        // belong to the caller. `want` gets the rows/columns decoded into
+        // `rows` and `xOffset` the iMCU-aligned first column.
+        bool readScanlines(const std::vector<uchar>& jpeg, int scaleDenom, const cv::Rect* region, bool gray,
+                           cv::Mat& rows, cv::Rect& want, int& xOffset){
+            jpeg_decompress_struct cinfo{};
+            JpegErrorManager err{};
+            cinfo.err = jpeg_std_error(&err.pub);
+            err.pub.error_exit = onJpegError;
+            err.pub.output_message = [](j_common_ptr) {};  // truncated frames would warn every time
+
+            if (setjmp(err.jump)){
+                jpeg_destroy_decompress(&cinfo);
+                return false;
+            }
+
+            jpeg_create_decompress(&cinfo);
+            jpeg_mem_src(&cinfo, jpeg.data(), static_cast<unsigned long>(jpeg.size()));
+            jpeg_read_header(&cinfo, TRUE);
+            cinfo.out_color_space = gray ? JCS_GRAYSCALE : JCS_EXT_BGR;
+            cinfo.scale_num = 1;
+            cinfo.scale_denom = region ? 1 : scaleDenom;
+            cinfo.dct_method = JDCT_IFAST;
+            jpeg_start_decompress(&cinfo);
+
+            want = cv::Rect{ 0, 0, static_cast<int>(cinfo.output_width), static_cast<int>(cinfo.output_height) };
+            if (region) want &= *region;
+            if (want.width <= 0 || want.height <= 0){
+                jpeg_abort_decompress(&cinfo);
+                jpeg_destroy_decompress(&cinfo);
+                return false;
+            }
+
+            // Cropping widens to iMCU boundaries; the exact columns are cut by the caller.
+            JDIMENSION offset{ static_cast<JDIMENSION>(want.x) };
+            JDIMENSION width{ static_cast<JDIMENSION>(want.width) };
+            if (region){
+                jpeg_crop_scanline(&cinfo, &offset, &width);
+                if (want.y > 0) jpeg_skip_scanlines(&cinfo, static_cast<JDIMENSION>(want.y));
+            }
+            xOffset = static_cast<int>(offset);
+
+            rows.create(want.height, static_cast<int>(width), gray ? CV_8UC1 : CV_8UC3);
+            while (cinfo.output_scanline < static_cast<JDIMENSION>(want.y + want.height)){
+                JSAMPROW row{ rows.ptr<uchar>(static_cast<int>(cinfo.output_scanline) - want.y) };
+                jpeg_read_scanlines(&cinfo, &row, 1);
+            }
+
+            // finish_decompress insists on every scanline being read.
+            if (cinfo.output_scanline < cinfo.output_height) jpeg_abort_decompress(&cinfo);
+            else jpeg_finish_decompress(&cinfo);
+            jpeg_destroy_decompress(&cinfo);
+            return true;
+        }
+
+        // Full image at 1/scaleDenom when `region` is null, otherwise only the
+        // rows and MCU columns covering `region` at full resolution. `gray`
+        // decodes just the Y component, skipping chroma upsampling and colour
+        // conversion.
+        bool decodeJpeg(const std::vector<uchar>& jpeg, int scaleDenom, const cv::Rect* region, bool gray, cv::Mat& out){
+            // A whole-image decode writes straight into `out`; a crop goes through
+            // a scratch image since its iMCU-aligned columns are wider.
+            cv::Mat scratch{};
+            cv::Mat& rows{ region ? scratch : out };
+            cv::Rect want{};
+            int xOffset{ 0 };
+            if (!readScanlines(jpeg, scaleDenom, region, gray, rows, want, xOffset)){
+                out.release();
+                return false;
+            }
+
+            if (region){
+                int cut{ want.x - xOffset };
+                out = (cut == 0 && rows.cols == want.width) ? rows : rows(cv::Rect(cut, 0, want.width, want.height)).clone();
+            }
+            return true;
+        }
+    }
+
+    MjpegSource::MjpegSource(int scaleDenom)
+        : m_scaleDenom(scaleDenom == 1 || scaleDenom == 2 || scaleDenom == 4 || scaleDenom == 8 ? scaleDenom : 2) {}
+
+    std::unique_ptr<MjpegSource> MjpegSource::fromFile(const std::string& path, int scaleDenom){
+        std::unique_ptr<MjpegSource> source{ new MjpegSource(scaleDenom) };
+        source->m_file.open(path, std::ios::binary);
+        if (!source->m_file) std::cerr << "Failed to open MJPEG file " << path << "\n";
+        return source;
+    }
+
+    std::unique_ptr<MjpegSource> MjpegSource::fromPipeline(const std::string& pipeline, int scaleDenom){
+        std::unique_ptr<MjpegSource> source{ new MjpegSource(scaleDenom) };
+        source->m_capture.open(pipeline, cv::CAP_GSTREAMER);
+        return source;
+    }
+
+    bool MjpegSource::isOpened() const { return m_capture.isOpened() || m_file.is_open(); }
+    double MjpegSource::downscale() const { return static_cast<double>(m_scaleDenom); }
+
+    void MjpegSource::setLumaOnly(bool lumaOnly){ m_lumaOnly = lumaOnly; }
+
+    bool MjpegSource::decodeScaled(const std::vector<uchar>& jpeg, int scaleDenom, bool gray, cv::Mat& out){
+        return decodeJpeg(jpeg, scaleDenom, nullptr, gray, out);
+    }
+
+    cv::Mat MjpegSource::decodeRegion(const std::vector<uchar>& jpeg, const cv::Rect& region){
+        cv::Mat out{};
+        decodeJpeg(jpeg, 1, &region, false, out);
+        return out;
+    }
+
+    bool MjpegSource::nextJpeg(std::vector<uchar>& out){
+        if (m_file.is_open()) return nextJpegFromFile(out);
+        if (!m_capture.isOpened() || !m_capture.read(m_buffer) || m_buffer.empty()) return false;
+
+        // An image/jpeg appsink hands over the compressed buffer as one row of bytes.
+        cv::Mat bytes{ m_buffer.isContinuous() ? m_buffer : m_buffer.clone() };
+        out.assign(bytes.data, bytes.data + bytes.total() * bytes.elemSize());
+        return true;
+    }
+
+    bool MjpegSource::nextJpegFromFile(std::vector<uchar>& out){
+        // Frames run from an SOI (FF D8) to the next EOI (FF D9). Entropy-coded
+        // data byte-stuffs FF, so EOI can't appear inside a frame.
+        constexpr std::size_t CHUNK{ 1 << 16 };
+        static const uchar SOI[]{ 0xFF, 0xD8 };
+        static const uchar EOI[]{ 0xFF, 0xD9 };
+
+        std::size_t scanned{ 2 };  // bytes of the current frame already searched for EOI
+        while (true){
+            auto start{ std::search(m_pending.begin(), m_pending.end(), std::begin(SOI), std::end(SOI)) };
+            if (start == m_pending.end()){
+                // Keep a trailing FF; it may be the first half of the next SOI.
+                bool keepLast{ !m_pending.empty() && m_pending.back() == 0xFF };
+                m_pending.erase(m_pending.begin(), m_pending.end() - (keepLast ? 1 : 0));
+                scanned = 2;
+            }
+            else{
+                if (start != m_pending.begin()){
+                    m_pending.erase(m_pending.begin(), start);
+                    scanned = 2;
+                }
+                auto end{ std::search(m_pending.begin() + scanned, m_pending.end(), std::begin(EOI), std::end(EOI)) };
+                if (end != m_pending.end()){
+                    out.assign(m_pending.begin(), end + 2);
+                    m_pending.erase(m_pending.begin(), end + 2);
+                    return true;
+                }
+                // Back up one byte in case the marker straddles two reads.
+                scanned = std::max<std::size_t>(2, m_pending.size() - 1);
+            }
+
+            if (!m_file) return false;
+            std::size_t old{ m_pending.size() };
+            m_pending.resize(old + CHUNK);
+            m_file.read(reinterpret_cast<char*>(m_pending.data() + old), CHUNK);
+            m_pending.resize(old + static_cast<std::size_t>(m_file.gcount()));
+            if (m_file.gcount() == 0) return false;
+        }
+    }
+
+    std::size_t MjpegSource::corruptFrames() const { return m_corruptFrames; }
+
+    bool MjpegSource::readInto(FrameContext& ctx){
+        std::vector<uchar>& jpeg{ ctx.encoded() };
+        cv::Mat& image{ ctx.prepare() };
+        FrameContext::Clock::time_point captured{};
+        // A glitched frame is dropped and the next one read; only a source
+        // that keeps sending garbage counts as failed.
+        for (int corrupt{ 0 };; ++corrupt){
+            if (!nextJpeg(jpeg)) return false;
+            captured = FrameContext::Clock::now();
+            if (decodeScaled(jpeg, m_scaleDenom, m_lumaOnly, image)) break;
+
+            ++m_corruptFrames;
+            if (corrupt + 1 >= MAX_CORRUPT_IN_A_ROW){
+                std::cerr << "MJPEG source: " << MAX_CORRUPT_IN_A_ROW << " corrupt frames in a row, giving up\n";
+                return false;
+            }
+        }
+
+        ctx.commit(m_lumaOnly ? FrameContext::PixelFormat::GRAY : FrameContext::PixelFormat::BGR, captured);
+        // The compressed frame stays in the context for full-resolution crops.
+        ctx.setFullResolution(m_scaleDenom, [bytes{ &jpeg }](const cv::Rect& region) {
+            return decodeRegion(*bytes, region);
+        });
+        return true;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "FrameSource.h"
+
+namespace NavigationVI{
+    // Motion-JPEG frames decoded with libjpeg-turbo's DCT scaling, so detection
+    // frames come out at 1/2 or 1/4 size without ever building the full-size
+    // image. Each FrameContext keeps the compressed frame and decodes full
+    // resolution only for the regions asked of fullResolutionRegion().
+    //
+    // Reads either a camera pipeline that hands over the JPEG buffers
+    // untouched (GStreamer "image/jpeg ! appsink") or a recorded .mjpeg file of
+    // back-to-back JPEGs, e.g. from "v4l2src ! image/jpeg ! filesink".
+    class MjpegSource : public FrameSource{
+        public:
+            // scaleDenom: 1, 2, 4 or 8.
+            static std::unique_ptr<MjpegSource> fromFile(const std::string& path, int scaleDenom = 2);
+            static std::unique_ptr<MjpegSource> fromPipeline(const std::string& pipeline, int scaleDenom = 2);
+
+            bool isOpened() const override;
+            // Corrupt JPEGs are skipped (see corruptFrames()); false only at the
+            // end of the stream, on a read error, or after MAX_CORRUPT_IN_A_ROW
+            // undecodable frames in a row.
+            bool readInto(FrameContext& ctx) override;
+            double downscale() const override;
+            std::size_t corruptFrames() const override;
+            // Decode only the Y component; colour crops are still decoded on demand.
+            void setLumaOnly(bool lumaOnly) override;
+
+            // BGR decode of the whole image at 1/scaleDenom (into `out`, reusing its
+            // buffer), or of `region` (in full-resolution pixels) at full
+            // resolution. False / empty on a corrupt frame.
+            static bool decodeScaled(const std::vector<uchar>& jpeg, int scaleDenom, bool gray, cv::Mat& out);
+            static cv::Mat decodeRegion(const std::vector<uchar>& jpeg, const cv::Rect& region);
+
+        private:
+            explicit MjpegSource(int scaleDenom);
+            bool nextJpeg(std::vector<uchar>& out);
+            bool nextJpegFromFile(std::vector<uchar>& out);
+
+        private:
+            static constexpr int MAX_CORRUPT_IN_A_ROW{ 30 };
+
+            int m_scaleDenom{ 2 };
+            std::size_t m_corruptFrames{ 0 };
+            bool m_lumaOnly{ false };
+
+            cv::VideoCapture m_capture{};
+            cv::Mat m_buffer{};
+
+            std::ifstream m_file{};
+            std::vector<uchar> m_pending{};  // file bytes not yet returned as a frame
+    };
+}
@@ -0,0 +1,33 @@
+#include "ObservationFusion.h"
+
+#include <algorithm>
+
+namespace NavigationVI{
+    std::optional<QRObservation> ObservationFusion::update(std::size_t camera, const std::optional<QRObservation>& seen, Clock::time_point now){
+        if (camera >= m_latest.size()){
+            m_latest.resize(camera + 1);
+            m_stats.picks.resize(camera + 1, 0);
+        }
+        m_latest[camera] = seen;
+
+        const QRObservation* best{ nullptr };
+        for (const auto& obs : m_latest){
+            if (!obs || now - obs->captured > m_maxAge) continue;
+            if (!best || score(*obs) < score(*best)) best = &*obs;
+        }
+        if (!best) return std::nullopt;
+
+        ++m_stats.picks[best->camera];
+        if (m_lastPick && *m_lastPick != best->camera) ++m_stats.handovers;
+        m_lastPick = best->camera;
+        return *best;
+    }
+
+    void ObservationFusion::setMaxAge(std::chrono::milliseconds maxAge){ m_maxAge = maxAge; }
+    ObservationFusion::Stats ObservationFusion::getStats() const { return m_stats; }
+
+    float ObservationFusion::score(const QRObservation& obs){
+        // Lower is better: metres, stretched as confidence drops.
+        return obs.code.distance / std::max(obs.confidence, MIN_CONFIDENCE);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include "../utils/QRCode.h"
+
+namespace NavigationVI{
+    // One camera's current view of its nearest code.
+    struct QRObservation{
+        std::size_t camera{ 0 };
+        QRCode code{};
+        float confidence{ 1.0f };  // 1 for a fresh detection, the tracker's otherwise
+        std::chrono::steady_clock::time_point captured{};
+    };
+
+    // Chooses one observation across cameras: the nearest code, with distance
+    // weighted by confidence so a shaky track loses to a solid detection. Each
+    // camera holds only its latest observation, which drops out after
+    // m_maxAge; a camera that stalls or loses the code therefore never holds
+    // up the others. Not thread-safe; callers serialise update().
+    class ObservationFusion{
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            struct Stats{
+                std::vector<std::size_t> picks{};  // per camera, times it was chosen
+                std::size_t handovers{ 0 };  // chosen camera changed
+            };
+
+            // `seen` is nullopt when `camera` sees no code. Returns the best current
+            // observation from any camera, or nullopt when none sees one.
+            std::optional<QRObservation> update(std::size_t camera, const std::optional<QRObservation>& seen, Clock::time_point now);
+
+            void setMaxAge(std::chrono::milliseconds maxAge);
+            Stats getStats() const;
+
+        private:
+            static float score(const QRObservation& obs);
+
+        private:
+            static constexpr float MIN_CONFIDENCE{ 0.1f };
+
+            std::vector<std::optional<QRObservation>> m_latest{};
+            std::chrono::milliseconds m_maxAge{ 500 };
+            std::optional<std::size_t> m_lastPick{};
+            Stats m_stats{};
+    };
+}
@@ -1,7 +1,10 @@
 #include "QRDetector.h"
+#include "LatencyHistogram.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <iterator>
 
 namespace NavigationVI{
     static inline bool minRoiOk(const cv::Rect& r, int minSide = 16) {
@@ -76,6 +79,8 @@ namespace NavigationVI{
                 cv::Scalar(170, 60, 50), cv::Scalar(179, 255, 255)
             }
         };
+
+        rebuildColourLut();
       }
     
       //   Destructor is not needed
@@ -94,9 +99,8 @@ namespace NavigationVI{
         m_minDetectionGapMs = std::max(0, minGapMs);
     }
 
-    bool QRDetector::shouldAttemptDetection(){
+    bool QRDetector::shouldAttemptDetection(std::chrono::steady_clock::time_point now){
         ++m_frameSkipCounter;
-        auto now{ std::chrono::steady_clock::now() };
         auto ms{ std::chrono::duration_cast<std::chrono::milliseconds>(now - m_lastDetectionTime).count() };
 
         bool intervalPassed{ m_frameSkipCounter >= m_detectionIntervalFrames };
@@ -110,6 +114,11 @@ namespace NavigationVI{
         return false;
     }
 
+    void QRDetector::restartDetectionThrottle(std::chrono::steady_clock::time_point now){
+        m_frameSkipCounter = 0;
+        m_lastDetectionTime = now;
+    }
+
     cv::Mat QRDetector::makeColourMask(const cv::Mat& hsv, QRColour colour) const{
         cv::Mat mask{ cv::Mat::zeros(hsv.size(), CV_8UC1) };
         if (colour == QRColour::NONE){
@@ -132,23 +141,183 @@ namespace NavigationVI{
 
         return mask;
     }
-    
-    std::vector<cv::Rect> QRDetector::findCandidateROIs(const cv::Mat& mask) const {
-        const double scale{ 0.5 };
-        cv::Mat smallMask;
-        cv::resize(mask, smallMask, cv::Size(), scale, scale, cv::INTER_NEAREST);
 
-        std::vector<std::vector<cv::Point>> contours;
-        cv::findContours(smallMask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    uchar QRDetector::colourBit(QRColour colour){
+        switch (colour){
+            case QRColour::RED: return 0x1;
+            case QRColour::GREEN: return 0x2;
+            case QRColour::BLUE: return 0x4;
+            default: return 0x0;
+        }
+    }
 
-        std::vector<cv::Rect> rois;
-        rois.reserve(contours.size());
+    void QRDetector::setColourRanges(QRColour colour, const std::vector<HSVRange>& ranges){
+        m_colourRanges[colour] = ranges;
+        rebuildColourLut();
+    }
+
+    void QRDetector::rebuildColourLut(){
+        constexpr int levels{ 1 << COLOUR_LUT_BITS };
+        constexpr int shift{ 8 - COLOUR_LUT_BITS };
+        constexpr int half{ (1 << shift) >> 1 };
+
+        cv::Mat cells(1, levels * levels * levels, CV_8UC3);
+        int idx{ 0 };
+        for (int b{ 0 }; b < levels; ++b)
+            for (int g{ 0 }; g < levels; ++g)
+                for (int r{ 0 }; r < levels; ++r)
+                    cells.at<cv::Vec3b>(0, idx++) = cv::Vec3b(
+                        static_cast<uchar>((b << shift) | half),
+                        static_cast<uchar>((g << shift) | half),
+                        static_cast<uchar>((r << shift) | half));
+
+        cv::Mat hsv{};
+        cv::cvtColor(cells, hsv, cv::COLOR_BGR2HSV);
+
+        m_colourLut.assign(static_cast<std::size_t>(cells.cols), 0);
+        for (const auto& [colour, ranges] : m_colourRanges){
+            uchar bit{ colourBit(colour) };
+            for (const auto& rng : ranges){
+                cv::Mat part{};
+                cv::inRange(hsv, rng.lower, rng.upper, part);
+                const uchar* hit{ part.ptr<uchar>(0) };
+                for (int i{ 0 }; i < part.cols; ++i)
+                    if (hit[i]) m_colourLut[i] |= bit;
+            }
+        }
+    }
+
+    // One pass per row: index the table with the top bits of B, G, R and
+    // store(entry) each pixel. The loop is bound by the table gather, so rows
+    // are split across threads rather than hand-vectorised.
+    template <int BITS, typename Store>
+    static void lookupColours(const cv::Mat& bgr, cv::Mat& out, const uchar* lut, Store store){
+        constexpr int shift{ 8 - BITS };
+        cv::parallel_for_(cv::Range(0, bgr.rows), [&](const cv::Range& rows) {
+            for (int y{ rows.start }; y < rows.end; ++y){
+                const uchar* src{ bgr.ptr<uchar>(y) };
+                uchar* dst{ out.ptr<uchar>(y) };
+                for (int x{ 0 }; x < bgr.cols; ++x, src += 3){
+                    int i{ ((src[0] >> shift) << (2 * BITS)) |
+                           ((src[1] >> shift) << BITS) |
+                           (src[2] >> shift) };
+                    dst[x] = store(lut[i]);
+                }
+            }
+        });
+    }
+
+    cv::Mat QRDetector::classifyColourBGR(const cv::Mat& bgr, QRColour colour) const{
+        cv::Mat mask{};
+        classifyColourBGR(bgr, colour, mask);
+        return mask;
+    }
+
+    void QRDetector::classifyColourBGR(const cv::Mat& bgr, QRColour colour, cv::Mat& out) const{
+        out.create(bgr.size(), CV_8UC1);
+        if (colour == QRColour::NONE){
+            out.setTo(255);
+            return;
+        }
+        CV_Assert(bgr.type() == CV_8UC3);
+
+        const uchar bit{ colourBit(colour) };
+        lookupColours<COLOUR_LUT_BITS>(bgr, out, m_colourLut.data(),
+            [bit](uchar entry) { return static_cast<uchar>((entry & bit) ? 255 : 0); });
+    }
+
+    cv::Mat QRDetector::labelColoursBGR(const cv::Mat& bgr) const{
+        cv::Mat labels{};
+        labelColoursBGR(bgr, labels);
+        return labels;
+    }
+
+    void QRDetector::labelColoursBGR(const cv::Mat& bgr, cv::Mat& out) const{
+        out.create(bgr.size(), CV_8UC1);
+        if (bgr.empty()) return;
+        CV_Assert(bgr.type() == CV_8UC3);
+
+        // Same gather as one colour; the entry already holds every colour's bit.
+        lookupColours<COLOUR_LUT_BITS>(bgr, out, m_colourLut.data(), [](uchar entry) { return entry; });
+    }
+
+    cv::Mat QRDetector::maskFromLabels(const cv::Mat& labels, QRColour colour){
+        cv::Mat mask{};
+        maskFromLabels(labels, colour, mask);
+        return mask;
+    }
+
+    void QRDetector::maskFromLabels(const cv::Mat& labels, QRColour colour, cv::Mat& out){
+        if (colour == QRColour::NONE){
+            out.create(labels.size(), CV_8UC1);
+            out.setTo(255);
+            return;
+        }
+        cv::bitwise_and(labels, cv::Scalar(colourBit(colour)), out);
+        cv::compare(out, 0, out, cv::CMP_NE);
+
+        cv::Mat kernel{ cv::getStructuringElement(cv::MORPH_RECT, {3,3}) };
+        cv::morphologyEx(out, out, cv::MORPH_OPEN, kernel);
+        cv::morphologyEx(out, out, cv::MORPH_CLOSE, kernel);
+    }
+
+    cv::Mat QRDetector::makeColourMaskBGR(const cv::Mat& bgr, QRColour colour) const{
+        cv::Mat mask{};
+        makeColourMaskBGR(bgr, colour, mask);
+        return mask;
+    }
 
-        for (const auto& c : contours) {
-            double area = cv::contourArea(c);
-            if (area < static_cast<double>(m_minAreaPx) * scale * scale) continue;
+    void QRDetector::makeColourMaskBGR(const cv::Mat& bgr, QRColour colour, cv::Mat& out) const{
+        classifyColourBGR(bgr, colour, out);
+        if (colour == QRColour::NONE) return;
 
-            cv::Rect bb = cv::boundingRect(c);
+        cv::Mat kernel{ cv::getStructuringElement(cv::MORPH_RECT, {3,3}) };
+        cv::morphologyEx(out, out, cv::MORPH_OPEN, kernel);
+        cv::morphologyEx(out, out, cv::MORPH_CLOSE, kernel);
+    }
+
+    // Colour masks are cut from the frame's labels, so the table gather runs
+    // once per frame however many colours are asked for.
+    static FrameContext::LabelBuilder labelsFrom(const QRDetector& detector){
+        return [&detector](const cv::Mat& bgr, cv::Mat& out) { detector.labelColoursBGR(bgr, out); };
+    }
+
+    static FrameContext::MaskBuilder cutFrom(const cv::Mat& labels){
+        return [&labels](const cv::Mat&, QRColour c, cv::Mat& out) { QRDetector::maskFromLabels(labels, c, out); };
+    }
+
+    const cv::Mat& QRDetector::colourMask(FrameContext& ctx, QRColour colour) const{
+        if (colour == QRColour::NONE)
+            return ctx.mask(colour, [this](const cv::Mat& bgr, QRColour c, cv::Mat& out) { makeColourMaskBGR(bgr, c, out); });
+        return ctx.mask(colour, cutFrom(ctx.labels(labelsFrom(*this))));
+    }
+
+    const cv::Mat& QRDetector::smallColourMask(FrameContext& ctx, QRColour colour) const{
+        if (colour == QRColour::NONE)
+            return ctx.smallMask(colour, [this](const cv::Mat& bgr, QRColour c, cv::Mat& out) { makeColourMaskBGR(bgr, c, out); });
+        // BGR frames shrink the full-size mask, others mask the small colour
+        // plane; the labels come from the same plane.
+        const cv::Mat& labels{ ctx.format() == FrameContext::PixelFormat::BGR
+            ? ctx.labels(labelsFrom(*this)) : ctx.smallLabels(labelsFrom(*this)) };
+        return ctx.smallMask(colour, cutFrom(labels));
+    }
+    
+    std::vector<cv::Rect> QRDetector::findCandidateROIs(const cv::Mat& smallMask, const cv::Mat& edgeSum, double scale) const {
+        cv::Mat labels{}, stats{}, centroids{};
+        int count{ cv::connectedComponentsWithStats(smallMask, labels, stats, centroids, 8, CV_32S) };
+
+        struct Candidate{
+            cv::Rect box{};  // full resolution
+            float score{ 0.0f };
+        };
+        std::vector<Candidate> candidates{};
+        candidates.reserve(static_cast<std::size_t>(std::max(0, count - 1)));
+        const cv::Rect gray{ 0, 0, std::max(0, edgeSum.cols - 1), std::max(0, edgeSum.rows - 1) };
+
+        for (int i{ 1 }; i < count; ++i) {  // 0 is the background
+            const int* st{ stats.ptr<int>(i) };
+            cv::Rect bb{ st[cv::CC_STAT_LEFT], st[cv::CC_STAT_TOP], st[cv::CC_STAT_WIDTH], st[cv::CC_STAT_HEIGHT] };
+            if (bb.area() < static_cast<double>(m_minAreaPx) * scale * scale) continue;
 
             // Scale ROI back to full resolution
             cv::Rect fullBB(
@@ -160,102 +329,248 @@ namespace NavigationVI{
 
             if (!isAspectOk(fullBB, m_aspectRatioLow, m_aspectRatioHigh)) continue;
 
-            rois.push_back(fullBB);
+            // A code is a mostly filled square full of module edges; a door,
+            // a shirt or a thin stripe of the same colour fails at least one.
+            float fill{ static_cast<float>(st[cv::CC_STAT_AREA]) / bb.area() };
+            float squareness{ static_cast<float>(std::min(bb.width, bb.height)) / std::max(bb.width, bb.height) };
+            float density{ CODE_EDGE_DENSITY };
+            cv::Rect e{ bb & gray };
+            if (e.area() > 0) {
+                int edges{ edgeSum.at<int>(e.y + e.height, e.x + e.width) - edgeSum.at<int>(e.y, e.x + e.width)
+                         - edgeSum.at<int>(e.y + e.height, e.x) + edgeSum.at<int>(e.y, e.x) };
+                density = static_cast<float>(edges) / e.area();
+            }
+            float score{ std::min(1.0f, fill / CODE_MIN_FILL) * squareness * std::min(1.0f, density / CODE_EDGE_DENSITY) };
+            candidates.push_back({ fullBB, score });
         }
 
-        std::sort(rois.begin(), rois.end(),
-                [](const cv::Rect& a, const cv::Rect& b) {
-                    return a.area() > b.area();
+        std::sort(candidates.begin(), candidates.end(),
+                [](const Candidate& a, const Candidate& b) {
+                    return a.score > b.score;
                 });
 
+        std::vector<cv::Rect> rois;
+        for (const auto& c : candidates) {
+            if (c.score < m_minCandidateScore || static_cast<int>(rois.size()) >= m_maxCandidates) break;
+            // Blobs inside one already kept (modules inside a coloured frame) are the same code.
+            bool inside{ std::any_of(rois.begin(), rois.end(), [&c](const cv::Rect& r) { return (c.box & r) == c.box; }) };
+            if (!inside) rois.push_back(c.box);
+        }
+
+        m_candidateStats.components += candidates.size();
+        m_candidateStats.cascades += rois.size();
         return rois;
     }
 
-    DetectResult QRDetector::robustDetectInROI(
-        const cv::Mat& frame,
-        const cv::Rect& roi,
-        bool tryDecode
-        ) const {
-            
-        DetectResult out{};
+    cv::Mat QRDetector::edgeIntegral(const cv::Mat& gray) {
+        cv::Mat sum{};
+        if (gray.cols < 2 || gray.rows < 2) return sum;
+
+        // 1 where the pixel to the right or below differs by EDGE_STEP or more.
+        cv::Mat edges{ cv::Mat::zeros(gray.size(), CV_8UC1) };
+        cv::Mat step{};
+        cv::absdiff(gray.colRange(1, gray.cols), gray.colRange(0, gray.cols - 1), step);
+        cv::Mat right{ edges.colRange(0, gray.cols - 1) };
+        cv::threshold(step, right, EDGE_STEP - 1, 1, cv::THRESH_BINARY);
+        cv::absdiff(gray.rowRange(1, gray.rows), gray.rowRange(0, gray.rows - 1), step);
+        cv::threshold(step, step, EDGE_STEP - 1, 1, cv::THRESH_BINARY);
+        cv::Mat down{ edges.rowRange(0, gray.rows - 1) };
+        cv::bitwise_or(down, step, down);
+
+        cv::integral(edges, sum, CV_32S);
+        return sum;
+    }
 
-        cv::Rect padded{ padRect(roi, m_bbboxPadding, frame.size()) };
-        padded &= cv::Rect{ 0, 0, frame.cols, frame.rows };
-        if (padded.width < 2 || padded.height < 2) return out;
+    // OpenCV's QR detector is costly to construct and not safe to share across
+    // threads, so each thread (including cv::parallel_for_ workers) keeps one.
+    static cv::QRCodeDetector& threadQRDetector() {
+        thread_local cv::QRCodeDetector qrd{};
+        return qrd;
+    }
 
-        cv::Mat roiBGR{ frame(padded).clone() };
-        if (roiBGR.empty()) return out;
+    static bool attemptVariant(
+        const cv::Mat& img,
+        bool decode,
+        const cv::Rect& padded,
+        const cv::Size& frameSize,
+        DetectResult& result) {
+        if (img.empty() || img.cols < 2 || img.rows < 2) return false;
+
+        std::vector<cv::Point> pts{};
+        std::string data{};
+
+        try{
+            cv::QRCodeDetector& qrd{ threadQRDetector() };
+            if (decode) data = qrd.detectAndDecode(img, pts);
+            else if (!qrd.detect(img, pts)) return false;
+        } catch (const cv::Exception& e){
+            std::cerr << "robustDetectInROI detect error: " << e.what() << std::endl;
+            return false;
+        }
+
+        if (pts.size() == 4) {
+            std::vector<cv::Point2f> corners{};
+            corners.reserve(4);
+            for (auto& p : pts) {
+                corners.emplace_back(
+                    static_cast<float>(p.x + padded.x),
+                    static_cast<float>(p.y + padded.y)
+                );
+            }
+            if(!polygonIsSane(corners)) return false;
 
-        cv::Mat gray{};
-        cv::cvtColor(roiBGR, gray, cv::COLOR_BGR2GRAY);
+            cv::Rect paddedBox{ bboxFromCorners(corners, 20, frameSize) };
+            if(!minRoiOk(paddedBox, 16)) return false;
 
-        cv::QRCodeDetector qrd{};
+            result.corners = std::move(corners);
+            result.bbox = paddedBox;
 
-        auto attempt = [&](const cv::Mat& img, bool decode, DetectResult& result) -> bool {
-            if (img.empty() || img.cols < 2 || img.rows < 2) return false;
+            result.content = decode ? data : std::string{};
+            result.found = decode ? (!data.empty()) : true;
+            return result.found;
+        }
+        return false;
+    }
 
-            std::vector<cv::Point> pts{};
-            std::string data{};
+    const char* QRDetector::variantName(Variant v){
+        switch (v){
+            case Variant::GRAY: return "gray";
+            case Variant::INV_GRAY: return "inv-gray";
+            case Variant::INV_BLUE: return "inv-blue";
+            case Variant::INV_GREEN: return "inv-green";
+            case Variant::INV_RED: return "inv-red";
+            case Variant::INV_OTSU: return "inv-otsu";
+            case Variant::INV_ADAPTIVE: return "inv-adaptive";
+            default: return "";
+        }
+    }
 
-            try{
-                if (decode) data = qrd.detectAndDecode(img, pts);
-                else if (!qrd.detect(img, pts)) return false;
-            } catch (const cv::Exception& e){
-                std::cerr << "robustDetectInROI detect error: " << e.what() << std::endl;
-                return false;
-            }
+    static bool isChannelVariant(QRDetector::Variant v){
+        return v == QRDetector::Variant::INV_BLUE || v == QRDetector::Variant::INV_GREEN || v == QRDetector::Variant::INV_RED;
+    }
 
-            if (pts.size() == 4) {
-                std::vector<cv::Point2f> corners{};
-                corners.reserve(4);
-                // result.corners.clear();
-                for (auto& p : pts) {
-                    corners.emplace_back(
-                        static_cast<float>(p.x + padded.x),
-                        static_cast<float>(p.y + padded.y)
-                    );
-                }
-                if(!polygonIsSane(corners)) return false;
+    cv::Mat QRDetector::makeVariant(Variant v, const cv::Mat& roiBGR, const cv::Mat& gray){
+        cv::Mat out{};
+        switch (v){
+            case Variant::GRAY:
+                return gray;
+            case Variant::INV_GRAY:
+                cv::bitwise_not(gray, out);
+                break;
+            case Variant::INV_BLUE:
+            case Variant::INV_GREEN:
+            case Variant::INV_RED:
+                cv::extractChannel(roiBGR, out, static_cast<int>(v) - static_cast<int>(Variant::INV_BLUE));
+                cv::bitwise_not(out, out);
+                break;
+            case Variant::INV_OTSU:
+                cv::threshold(gray, out, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+                break;
+            case Variant::INV_ADAPTIVE:
+                cv::adaptiveThreshold(gray, out, 255, cv::ADAPTIVE_THRESH_GAUSSIAN_C,
+                                    cv::THRESH_BINARY_INV, 11, 2);
+                break;
+            default:
+                break;
+        }
+        return out;
+    }
 
-                cv::Rect paddedBox{ bboxFromCorners(corners, 20, frame.size()) };
-                if(!minRoiOk(paddedBox, 16)) return false;
+    std::array<QRDetector::Variant, QRDetector::VARIANT_COUNT> QRDetector::variantOrder() const{
+        std::array<Variant, VARIANT_COUNT> order{};
+        std::array<float, VARIANT_COUNT> rate{};
+        {
+            std::lock_guard<std::mutex> lock(m_variantMutex);
+            for (int i{ 0 }; i < VARIANT_COUNT; ++i) rate[i] = m_variantStats[i].recentRate;
+        }
+        for (int i{ 0 }; i < VARIANT_COUNT; ++i) order[i] = static_cast<Variant>(i);
+        std::stable_sort(order.begin(), order.end(), [&rate](Variant a, Variant b) {
+            return rate[static_cast<int>(a)] > rate[static_cast<int>(b)];
+        });
+        return order;
+    }
 
-                result.corners = std::move(corners);
-                result.bbox = paddedBox;
+    void QRDetector::recordVariant(Variant v, bool hit) const{
+        std::lock_guard<std::mutex> lock(m_variantMutex);
+        VariantStat& st{ m_variantStats[static_cast<int>(v)] };
+        ++st.attempts;
+        if (hit) ++st.hits;
+        st.recentRate += VARIANT_RATE_ALPHA * ((hit ? 1.0f : 0.0f) - st.recentRate);
+    }
 
-                result.content = decode ? data : std::string{};
-                result.found = decode ? (!data.empty()) : true;
-                return result.found;
-            }
-            return false;
-        };
+    std::vector<QRDetector::VariantStat> QRDetector::getVariantStats() const{
+        std::lock_guard<std::mutex> lock(m_variantMutex);
+        return std::vector<VariantStat>(m_variantStats.begin(), m_variantStats.end());
+    }
 
-        if (attempt(gray, tryDecode, out)) return out;
+    DetectResult QRDetector::robustDetectInROI(
+        FrameContext& ctx,
+        const cv::Rect& roi,
+        bool tryDecode
+        ) const {
+            
+        ScopedLatency timer{ LatencyStage::RobustDetect };
+        DetectResult out{};
+        const cv::Size frameSize{ ctx.size() };
 
-        cv::Mat invGray{}; cv::bitwise_not(gray, invGray);
-        if (attempt(invGray, tryDecode, out)) return out;
+        cv::Rect padded{ padRect(roi, m_bbboxPadding, frameSize) };
+        padded &= cv::Rect{ 0, 0, frameSize.width, frameSize.height };
+        if (padded.width < 2 || padded.height < 2) return out;
 
-        {
-            std::vector<cv::Mat> ch{};
-            cv::split(roiBGR, ch);
-            for (auto& c : ch) {
-                cv::Mat inv{};
-                cv::bitwise_not(c, inv);
-                if (attempt(inv, tryDecode, out)) return out;
-            }
+        // Views into the shared planes; every variant below writes to new Mats.
+        cv::Mat gray{ ctx.gray()(padded) };
+        if (gray.empty()) return out;
+
+        // The per-channel variants need colour; a frame that arrived as
+        // luminance or YUV skips them rather than converting for them.
+        cv::Mat roiBGR{};
+        if (ctx.format() == FrameContext::PixelFormat::BGR) roiBGR = ctx.bgr()(padded);
+
+        // Variants are tried best-recent-hit-rate first, so a miss under the
+        // current lighting costs fewer detector passes.
+        auto order{ variantOrder() };
+        if (roiBGR.empty()) {
+            auto end{ std::remove_if(order.begin(), order.end(), isChannelVariant) };
+            std::fill(end, order.end(), Variant::GRAY);
         }
+        int variantCount{ roiBGR.empty() ? VARIANT_COUNT - 3 : VARIANT_COUNT };
+        int next{ 0 };
+
+        int parallel{ std::min(m_parallelVariants, variantCount) };
+        if (parallel > 1) {
+            // Evaluate the leading variants side by side. A variant ranked below a
+            // hit is skipped, but every variant ranked above the best hit so far
+            // still runs, so the best-ranked hit wins whatever the scheduling.
+            enum : char { NOT_TRIED, MISS, HIT };
+            std::array<DetectResult, VARIANT_COUNT> results{};
+            std::array<char, VARIANT_COUNT> state{};
+            std::atomic<int> bestHit{ parallel };
+
+            cv::parallel_for_(cv::Range(0, parallel), [&](const cv::Range& r) {
+                for (int k{ r.start }; k < r.end; ++k) {
+                    if (k > bestHit.load(std::memory_order_relaxed)) continue;
+                    cv::Mat img{ makeVariant(order[k], roiBGR, gray) };
+                    bool hit{ attemptVariant(img, tryDecode, padded, frameSize, results[k]) };
+                    state[k] = hit ? HIT : MISS;
+                    if (!hit) continue;
+                    int best{ bestHit.load(std::memory_order_relaxed) };
+                    while (k < best && !bestHit.compare_exchange_weak(best, k, std::memory_order_relaxed)) {}
+                }
+            });
 
-        cv::Mat otsu{};
-        cv::threshold(gray, otsu, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
-
-        cv::Mat invOtsu{}; cv::bitwise_not(otsu, invOtsu);
-        if (attempt(invOtsu, tryDecode, out)) return out;
+            for (int k{ 0 }; k < parallel; ++k)
+                if (state[k] != NOT_TRIED) recordVariant(order[k], state[k] == HIT);
+            for (int k{ 0 }; k < parallel; ++k)
+                if (state[k] == HIT) return results[k];
+            next = parallel;
+        }
 
-        cv::Mat adap{};
-        cv::adaptiveThreshold(gray, adap, 255, cv::ADAPTIVE_THRESH_GAUSSIAN_C,
-                            cv::THRESH_BINARY, 11, 2);
-        cv::Mat invAdap{}; cv::bitwise_not(adap, invAdap);
-        if (attempt(invAdap, tryDecode, out)) return out;
+        for (; next < variantCount; ++next) {
+            cv::Mat img{ makeVariant(order[next], roiBGR, gray) };
+            bool hit{ attemptVariant(img, tryDecode, padded, frameSize, out) };
+            recordVariant(order[next], hit);
+            if (hit) return out;
+        }
         
         return out;
     }
@@ -277,20 +592,13 @@ namespace NavigationVI{
         return 0.5f * (static_cast<float>(r.width) + static_cast<float>(r.height));
     }
 
-    bool QRDetector::verifyColourInROI(const cv::Mat& frame, const cv::Rect& roi, QRColour colour) const{
+    bool QRDetector::verifyColourInROI(FrameContext& ctx, const cv::Rect& roi, QRColour colour) const{
         if (colour == QRColour::NONE) return true;
-        cv::Mat bgr{ frame(roi) };
-        cv::Mat hsv{}; cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
-
-        auto it{ m_colourRanges.find(colour) };
-        if (it == m_colourRanges.end()) return false;
+        if (!m_colourRanges.count(colour)) return false;
 
-        cv::Mat accum{ cv::Mat::zeros(hsv.size(), CV_8UC1) };
-        for (const auto& rng : it->second){
-            cv::Mat part{};
-            cv::inRange(hsv, rng.lower, rng.upper, part);
-            cv::bitwise_or(accum, part, accum);
-        }
+        cv::Mat roiBGR{ ctx.bgrRegion(roi) };
+        if (roiBGR.empty()) return false;
+        cv::Mat accum{ classifyColourBGR(roiBGR, colour) };
 
         double ratio{ static_cast<double>(cv::countNonZero(accum)) / (accum.rows * accum.cols + 1e-6) };
         return ratio > 0.25;
@@ -302,27 +610,32 @@ namespace NavigationVI{
     }
 
     std::vector<QRCode> QRDetector::detectQRCodes(const cv::Mat& frame, bool tryDecode) {
-        std::vector<QRCode> out{};
-        if (frame.empty()) return out;
+        FrameContext ctx{ frame };
+        return detectQRCodes(ctx, tryDecode);
+    }
 
-        cv::Mat hsv{}; cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
-        cv::Mat mask{ makeColourMask(hsv, m_targetColour) };
-        auto rois{ findCandidateROIs(mask) };
+    void QRDetector::collectCodes(
+        FrameContext& ctx,
+        const std::vector<cv::Rect>& rois,
+        QRColour colour,
+        bool tryDecode,
+        std::vector<QRCode>& out) const {
+        const cv::Size frameSize{ ctx.size() };
 
         for (const auto& roi : rois) {
-            auto det{ robustDetectInROI(frame, roi, tryDecode) };
+            auto det{ robustDetectInROI(ctx, roi, tryDecode) };
             if (!det.found) continue;
 
             cv::Rect box{};
             if(det.corners.size() == 4)
-                box = bboxFromCorners(det.corners, m_bbboxPadding, frame.size());
+                box = bboxFromCorners(det.corners, m_bbboxPadding, frameSize);
             else{
                 box = det.bbox.area() > 0 ? det.bbox : roi;
-                box &= cv::Rect(0, 0, frame.cols, frame.rows);
+                box &= cv::Rect(0, 0, frameSize.width, frameSize.height);
             }
 
             if(!minRoiOk(box, 16)) continue;
-            if (m_colourVerifyEnabled && !verifyColourInROI(frame, box, m_targetColour)) continue;
+            if (m_colourVerifyEnabled && !verifyColourInROI(ctx, box, colour)) continue;
 
             QRCode qr{};
             qr.position = cv::Point2f{
@@ -330,7 +643,7 @@ namespace NavigationVI{
                 box.y + box.height * 0.5f
             };
             qr.content = tryDecode ? det.content : std::string{};
-            qr.colour = m_targetColour;
+            qr.colour = colour;
             float px{ averageSide(box) };
             qr.distance = estimateDistancePxToMeters(px, m_referencePx, m_referenceMeters);
             qr.bbox = box;
@@ -338,16 +651,161 @@ namespace NavigationVI{
 
             out.push_back(qr);
         }
+    }
+
+    cv::Rect QRDetector::predictSearchWindow(const cv::Size& frameSize, FrameContext::Clock::time_point now) const {
+        const cv::Rect& last{ *m_lastBox };
+        float dt{ std::max(0.0f, std::chrono::duration<float>(now - m_lastBoxTime).count()) };
+        cv::Point2f drift{ m_lastBoxVelocity * dt };
+
+        // Grow by the expected motion plus half the code size for what the
+        // constant-velocity guess misses.
+        int margin{ std::max(40, std::max(last.width, last.height) / 2) };
+        int growX{ margin + static_cast<int>(std::fabs(drift.x)) };
+        int growY{ margin + static_cast<int>(std::fabs(drift.y)) };
+        cv::Rect window{
+            last.x + static_cast<int>(drift.x) - growX,
+            last.y + static_cast<int>(drift.y) - growY,
+            last.width + 2 * growX,
+            last.height + 2 * growY
+        };
+        return window & cv::Rect{ 0, 0, frameSize.width, frameSize.height };
+    }
+
+    std::vector<cv::Rect> QRDetector::findCandidatesInWindow(FrameContext& ctx, const cv::Rect& window, QRColour colour,
+                                                             cv::Mat& windowLabels, cv::Mat& windowEdges) const {
+        if (colour == QRColour::NONE) return { window };
+
+        // Reuse the full mask if the UI already built it; otherwise label
+        // only the window, once for all colours.
+        cv::Mat smallMask{};
+        {
+            ScopedLatency timer{ LatencyStage::ColourMask };
+            cv::Mat windowMask{};
+            if (const cv::Mat* full{ ctx.cachedMask(colour) }) {
+                windowMask = (*full)(window);
+            } else {
+                if (windowLabels.empty()) windowLabels = labelColoursBGR(ctx.bgrRegion(window));
+                windowMask = maskFromLabels(windowLabels, colour);
+            }
+            cv::resize(windowMask, smallMask, cv::Size(), FrameContext::SMALL_SCALE, FrameContext::SMALL_SCALE, cv::INTER_NEAREST);
+        }
+
+        std::vector<cv::Rect> rois{};
+        {
+            ScopedLatency timer{ LatencyStage::CandidateRois };
+            if (windowEdges.empty()) {
+                cv::Mat smallGray{};
+                cv::resize(ctx.gray()(window), smallGray, smallMask.size(), 0, 0, cv::INTER_AREA);
+                windowEdges = edgeIntegral(smallGray);
+            }
+            rois = findCandidateROIs(smallMask, windowEdges, FrameContext::SMALL_SCALE);
+        }
+        for (auto& r : rois) {
+            r += window.tl();
+            r &= cv::Rect{ 0, 0, ctx.size().width, ctx.size().height };
+        }
+        return rois;
+    }
+
+    void QRDetector::rememberNearest(const std::vector<QRCode>& codes, FrameContext::Clock::time_point when) {
+        auto nearest{ findNearestQRCode(codes) };
+        if (!nearest) {
+            m_lastBox.reset();
+            m_lastBoxVelocity = cv::Point2f{ 0.0f, 0.0f };
+            return;
+        }
+
+        if (m_lastBox) {
+            float dt{ std::chrono::duration<float>(when - m_lastBoxTime).count() };
+            if (dt > 1e-3f) {
+                cv::Point2f prevCentre{ m_lastBox->x + m_lastBox->width * 0.5f, m_lastBox->y + m_lastBox->height * 0.5f };
+                m_lastBoxVelocity = (nearest->position - prevCentre) * (1.0f / dt);
+            }
+        }
+        m_lastBox = nearest->bbox;
+        m_lastBoxTime = when;
+    }
+
+    std::vector<QRCode> QRDetector::detectQRCodes(FrameContext& ctx, bool tryDecode) {
+        using Clock = std::chrono::steady_clock;
+        std::vector<QRCode> out{};
+        if (ctx.empty()) return out;
+        const cv::Size frameSize{ ctx.size() };
+        if (m_targetColour != QRColour::NONE) ++m_candidateStats.frames;
+
+        auto start{ Clock::now() };
+        auto elapsedMs{ [&start] { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); } };
+
+        // Full-frame candidates for some colours; every colour's mask comes from
+        // the same labelling pass. Without a target colour an all-255 mask would
+        // only yield the whole frame, so that case uses the whole-frame search below.
+        // Masks and searches are timed here rather than where they are built, so
+        // the display's mask and the shared edge sum don't add samples of their own.
+        cv::Mat edgeSum{};
+        auto scanFullFrame{ [&](auto first, auto last) {
+            if (m_targetColour == QRColour::NONE || first == last) return;
+            for (auto it{ first }; it != last; ++it) {
+                const cv::Mat* mask{};
+                {
+                    ScopedLatency timer{ LatencyStage::ColourMask };
+                    mask = &smallColourMask(ctx, *it);
+                }
+                std::vector<cv::Rect> rois{};
+                {
+                    ScopedLatency timer{ LatencyStage::CandidateRois };
+                    if (edgeSum.empty()) edgeSum = edgeIntegral(ctx.smallGray());
+                    rois = findCandidateROIs(*mask, edgeSum, FrameContext::SMALL_SCALE);
+                }
+                collectCodes(ctx, rois, *it, tryDecode, out);
+            }
+        } };
+        // The window follows the route colour only; alert colours can turn up anywhere.
+        auto rememberRouteCode{ [&] {
+            std::vector<QRCode> route{};
+            std::copy_if(out.begin(), out.end(), std::back_inserter(route),
+                [this](const QRCode& qr) { return qr.colour == m_targetColour; });
+            rememberNearest(route, ctx.captureTime());
+        } };
+
+        // Fast path: look where the route code was last time. Every
+        // m_fullSearchInterval detections the whole frame is searched anyway, so a
+        // nearer code that appears elsewhere isn't missed for long. Alert colours
+        // are still searched over the whole frame on a hit.
+        bool periodicFull{ ++m_detectionsSinceFull >= m_fullSearchInterval };
+        double fastMs{ 0.0 };
+        if (m_predictedRoiEnabled && m_lastBox && !periodicFull) {
+            cv::Rect window{ predictSearchWindow(frameSize, ctx.captureTime()) };
+            if (window.width >= 16 && window.height >= 16) {
+                ++m_roiStats.fastAttempts;
+                cv::Mat windowLabels{}, windowEdges{};
+                collectCodes(ctx, findCandidatesInWindow(ctx, window, m_targetColour, windowLabels, windowEdges),
+                             m_targetColour, tryDecode, out);
+                if (!out.empty()) {
+                    scanFullFrame(std::next(m_targetColours.begin()), m_targetColours.end());
+                    fastMs = elapsedMs();
+                    ++m_roiStats.fastHits;
+                    m_roiStats.savedMs += std::max(0.0, m_roiStats.avgFullMs - fastMs);
+                    rememberRouteCode();
+                    return out;
+                }
+                m_roiStats.savedMs -= elapsedMs();  // wasted on a miss
+            }
+        }
+        m_detectionsSinceFull = 0;
+        start = Clock::now();
+
+        scanFullFrame(m_targetColours.begin(), m_targetColours.end());
 
         if (out.empty() && m_targetColour == QRColour::NONE) {
-            cv::Rect full{ 0, 0, frame.cols, frame.rows };
-            auto det{ robustDetectInROI(frame, full, tryDecode) };
+            cv::Rect full{ 0, 0, frameSize.width, frameSize.height };
+            auto det{ robustDetectInROI(ctx, full, tryDecode) };
             if (det.found) {
                 cv::Rect box{};
-                if (det.corners.size() == 4) box = bboxFromCorners(det.corners, m_bbboxPadding, frame.size());
+                if (det.corners.size() == 4) box = bboxFromCorners(det.corners, m_bbboxPadding, frameSize);
                 else{
                     box = det.bbox.area() ? det.bbox : full;
-                    box &= cv::Rect(0,0, frame.cols, frame.rows);
+                    box &= cv::Rect(0,0, frameSize.width, frameSize.height);
                 }
                 if (minRoiOk(box, 16)){
                     QRCode qr{};
@@ -365,8 +823,69 @@ namespace NavigationVI{
                 }
             }
         }
+
+        double fullMs{ elapsedMs() };
+        ++m_roiStats.fullSearches;
+        m_roiStats.avgFullMs = m_roiStats.fullSearches == 1 ? fullMs : 0.9 * m_roiStats.avgFullMs + 0.1 * fullMs;
+        rememberRouteCode();
         return out;
-    }    
+    }
+
+    void QRDetector::setPredictedRoiSearch(bool enabled, int fullSearchInterval) {
+        m_predictedRoiEnabled = enabled;
+        m_fullSearchInterval = std::max(1, fullSearchInterval);
+        m_lastBox.reset();
+    }
+
+    QRDetector::RoiSearchStats QRDetector::getRoiSearchStats() const { return m_roiStats; }
+
+    void QRDetector::setCandidateLimit(int maxCandidates, float minScore) {
+        m_maxCandidates = std::max(1, maxCandidates);
+        m_minCandidateScore = std::max(0.0f, minScore);
+    }
+
+    QRDetector::CandidateStats QRDetector::getCandidateStats() const { return m_candidateStats; }
+
+    std::vector<double> QRDetector::decodeScalesFor(const QRCode& qr, int targetWidthPx, double cropScale) const{
+        // The code's own width: from its corners when the detector found them
+        // (the bbox carries the padding), otherwise back from the distance.
+        float codePx{ 0.0f };
+        if (qr.corners.size() == 4) {
+            for (int i{ 0 }; i < 4; ++i)
+                codePx = std::max(codePx, static_cast<float>(cv::norm(qr.corners[i] - qr.corners[(i + 1) % 4])));
+        }
+        else if (std::isfinite(qr.distance) && qr.distance > 0.0f) {
+            codePx = static_cast<float>(m_referencePx * m_referenceMeters / qr.distance * cropScale);
+        }
+        if (codePx <= 1.0f) return {};
+
+        double needed{ targetWidthPx / static_cast<double>(codePx) };
+        if (needed <= 1.0) return { 1.0 };
+        if (needed > m_maxDecodeUpscale) return {};
+
+        // Distance estimates are rough; a second, larger level covers codes a
+        // little further away than estimated.
+        std::vector<double> scales{ std::ceil(needed * 4.0) / 4.0 };
+        double larger{ std::min(m_maxDecodeUpscale, scales.front() * 1.5) };
+        if (larger > scales.front() + 0.25) scales.push_back(larger);
+        return scales;
+    }
+
+    cv::Mat QRDetector::upscaleForDecode(const cv::Mat& crop, double scale){
+        if (crop.empty() || scale <= 1.0) return crop;
+
+        cv::Mat up{};
+        cv::resize(crop, up, cv::Size(), scale, scale, cv::INTER_CUBIC);
+
+        // Cubic interpolation blurs module edges; an unsharp mask restores
+        // enough contrast for the binariser.
+        cv::Mat blurred{};
+        cv::GaussianBlur(up, blurred, cv::Size(0, 0), scale * 0.5);
+        cv::addWeighted(up, 1.5, blurred, -0.5, 0.0, up);
+        return up;
+    }
+
+    void QRDetector::setMaxDecodeUpscale(double scale){ m_maxDecodeUpscale = std::max(1.0, scale); }
 
     std::optional<QRCode> QRDetector::findNearestQRCode(const std::vector<QRCode>& codes) const{
         if (codes.empty()) return std::nullopt;
@@ -412,12 +931,24 @@ namespace NavigationVI{
         return cmd;
     }
 
-    void QRDetector::setTargetColour(QRColour colour){ m_targetColour = colour; }
+    void QRDetector::setTargetColour(QRColour colour){ setTargetColours({ colour }); }
     QRColour QRDetector::getTargetColour() const{ return m_targetColour; }
+
+    void QRDetector::setTargetColours(const std::vector<QRColour>& colours){
+        m_targetColours.clear();
+        for (QRColour c : colours)
+            if (std::find(m_targetColours.begin(), m_targetColours.end(), c) == m_targetColours.end()) m_targetColours.push_back(c);
+        bool any{ m_targetColours.empty() || std::find(m_targetColours.begin(), m_targetColours.end(), QRColour::NONE) != m_targetColours.end() };
+        if (any) m_targetColours = { QRColour::NONE };
+        m_targetColour = m_targetColours.front();
+    }
+
+    const std::vector<QRColour>& QRDetector::getTargetColours() const{ return m_targetColours; }
     void QRDetector::setMinArea(int area) { m_minAreaPx = area; }
     void QRDetector::setAspectRatioTolerance(float low, float high) { m_aspectRatioLow = low; m_aspectRatioHigh = high; }
     void QRDetector::setBoundingBoxPadding(int px){ m_bbboxPadding = px; }
     void QRDetector::setDistanceReference(float pxAt1m, float meters){ m_referencePx = pxAt1m; m_referenceMeters = meters; }
     void QRDetector::setColourVerificationEnabled(bool enabled) { m_colourVerifyEnabled = enabled; }
+    void QRDetector::setParallelVariants(int count) { m_parallelVariants = std::max(1, count); }
     bool QRDetector::getColourVerificationEnabled() const { return m_colourVerifyEnabled; }
 }
\ No newline at end of file
@@ -1,14 +1,17 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <vector>
 #include <optional>
 #include <map>
+#include <mutex>
 #include <chrono>
 
 #include <opencv2/opencv.hpp>
 
 #include "../utils/QRCode.h"
+#include "FrameContext.h"
 
 namespace NavigationVI{
 
@@ -20,12 +23,21 @@ namespace NavigationVI{
             void release();
 
             void setTargetColour(const QRColour colour);
-            QRColour getTargetColour() const;
+            QRColour getTargetColour() const;  // the first target colour
+            // Several colours searched together; codes come back tagged with
+            // theirs. NONE anywhere in the list means any code, colour ignored.
+            void setTargetColours(const std::vector<QRColour>& colours);
+            const std::vector<QRColour>& getTargetColours() const;
             
             void setDetectionThrottle(int framesInterval, int minGapMs);
-            bool shouldAttemptDetection();
+            // `now` is the frame's time, so a replayed recording throttles the
+            // same way on every run.
+            bool shouldAttemptDetection(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+            // Starts the throttle over as if a detection had just run at `now`.
+            void restartDetectionThrottle(std::chrono::steady_clock::time_point now);
 
             std::vector<QRCode> detectQRCodes(const cv::Mat& frame, bool tryDecode = false);
+            std::vector<QRCode> detectQRCodes(FrameContext& ctx, bool tryDecode = false);
             std::optional<QRCode> findNearestQRCode(const std::vector<QRCode>& codes) const;
             NavigationCommand getNavigationToQR(const QRCode& qr, const cv::Size& frameSize) const;
 
@@ -37,6 +49,76 @@ namespace NavigationVI{
             void setColourVerificationEnabled(bool enabled);
             bool getColourVerificationEnabled() const;
             cv::Mat makeColourMask(const cv::Mat& hsv, QRColour colour) const;
+            // Same mask straight from BGR through the colour lookup table.
+            // The `out` forms reuse the buffer already in `out` when it fits.
+            cv::Mat makeColourMaskBGR(const cv::Mat& bgr, QRColour colour) const;
+            void makeColourMaskBGR(const cv::Mat& bgr, QRColour colour, cv::Mat& out) const;
+            cv::Mat classifyColourBGR(const cv::Mat& bgr, QRColour colour) const;  // no morphology
+            void classifyColourBGR(const cv::Mat& bgr, QRColour colour, cv::Mat& out) const;
+            // Every configured colour in one pass: each pixel holds the bits
+            // (see maskFromLabels) of the colours it matches.
+            cv::Mat labelColoursBGR(const cv::Mat& bgr) const;
+            void labelColoursBGR(const cv::Mat& bgr, cv::Mat& out) const;
+            // One colour's mask, with the same morphology as makeColourMaskBGR.
+            static cv::Mat maskFromLabels(const cv::Mat& labels, QRColour colour);
+            static void maskFromLabels(const cv::Mat& labels, QRColour colour, cv::Mat& out);
+            void setColourRanges(QRColour colour, const std::vector<HSVRange>& ranges);
+            // Cached on the context so every stage of a frame's detection shares one
+            // mask; all colours of a frame are cut from one labelling pass.
+            const cv::Mat& colourMask(FrameContext& ctx, QRColour colour) const;
+            const cv::Mat& smallColourMask(FrameContext& ctx, QRColour colour) const;
+
+            // robustDetectInROI: how many of the leading image variants to run
+            // concurrently (1 = strictly one after another).
+            void setParallelVariants(int count);
+
+            // Image variants robustDetectInROI tries, in their original fixed order.
+            enum class Variant : int { GRAY, INV_GRAY, INV_BLUE, INV_GREEN, INV_RED, INV_OTSU, INV_ADAPTIVE };
+            static constexpr int VARIANT_COUNT{ 7 };
+            static const char* variantName(Variant v);
+
+            struct VariantStat{
+                std::size_t attempts{ 0 };
+                std::size_t hits{ 0 };
+                float recentRate{ 0.0f };  // exponentially weighted hit rate
+            };
+            std::vector<VariantStat> getVariantStats() const;  // indexed by Variant
+
+            // Search a window around the last detected code before the whole
+            // frame; every fullSearchInterval detections the full frame is used.
+            void setPredictedRoiSearch(bool enabled, int fullSearchInterval = 10);
+
+            struct RoiSearchStats{
+                std::size_t fastAttempts{ 0 };
+                std::size_t fastHits{ 0 };
+                std::size_t fullSearches{ 0 };
+                double avgFullMs{ 0.0 };   // moving average of a full-frame search
+                double savedMs{ 0.0 };     // estimated total, net of fast-path misses
+            };
+            RoiSearchStats getRoiSearchStats() const;
+
+            // Colour-mask regions are ranked by a cheap score (fill ratio x
+            // squareness x module-edge density) and only the best maxCandidates
+            // scoring at least minScore go on to robustDetectInROI.
+            void setCandidateLimit(int maxCandidates, float minScore);
+
+            struct CandidateStats{
+                std::size_t frames{ 0 };      // detections that searched colour masks
+                std::size_t components{ 0 };  // regions that passed the size and aspect checks
+                std::size_t cascades{ 0 };    // of those, sent on to robustDetectInROI
+            };
+            CandidateStats getCandidateStats() const;
+
+            // Multi-scale decoding for codes too small to decode as seen. Returns
+            // the upsampling factors to try on a full-resolution crop, most likely
+            // first, chosen from the code's estimated distance so that it comes out
+            // about targetWidthPx wide. {1.0} if it is already large enough, empty
+            // if it would need more than the maximum upscale. `qr.corners` are taken
+            // in crop pixels; `cropScale` (crop pixels per frame pixel) converts the
+            // distance estimate, which is in frame pixels.
+            std::vector<double> decodeScalesFor(const QRCode& qr, int targetWidthPx, double cropScale = 1.0) const;
+            static cv::Mat upscaleForDecode(const cv::Mat& crop, double scale);
+            void setMaxDecodeUpscale(double scale);
             
         // optional: Can delete later
         public:
@@ -46,6 +128,7 @@ namespace NavigationVI{
         private:
             cv::VideoCapture m_camera{};
             QRColour m_targetColour{ QRColour::NONE };
+            std::vector<QRColour> m_targetColours{ QRColour::NONE };
 
             int m_minAreaPx{ 1000 };
             float m_aspectRatioLow{ 0.6f };
@@ -62,16 +145,58 @@ namespace NavigationVI{
 
             std::chrono::steady_clock::time_point m_lastDetectionTime{};
 
-            std::map<QRColour, std::vector<HSVRange>> m_colourRanges{};
+            static constexpr float VARIANT_RATE_ALPHA{ 0.05f };
+            int m_parallelVariants{ 1 };
+            mutable std::mutex m_variantMutex{};
+            mutable std::array<VariantStat, VARIANT_COUNT> m_variantStats{};
+
+            static cv::Mat makeVariant(Variant v, const cv::Mat& roiBGR, const cv::Mat& gray);
+            std::array<Variant, VARIANT_COUNT> variantOrder() const;
+            void recordVariant(Variant v, bool hit) const;
 
-            std::vector<cv::Rect> findCandidateROIs(const cv::Mat& mask) const;
+            std::map<QRColour, std::vector<HSVRange>> m_colourRanges{};
 
-            DetectResult robustDetectInROI(const cv::Mat& frame, const cv::Rect& roi, bool tryDecode) const;
+            // Quantised BGR (COLOUR_LUT_BITS per channel, B major) -> colourBit mask,
+            // built from m_colourRanges by running OpenCV's own BGR->HSV on each cell centre.
+            static constexpr int COLOUR_LUT_BITS{ 6 };
+            std::vector<uchar> m_colourLut{};
+            void rebuildColourLut();
+            static uchar colourBit(QRColour colour);
+
+            // `edgeSum` is edgeIntegral() of the gray image under `smallMask`.
+            std::vector<cv::Rect> findCandidateROIs(const cv::Mat& smallMask, const cv::Mat& edgeSum, double scale) const;
+            // Integral image of a map of gray-level steps of EDGE_STEP or more.
+            static cv::Mat edgeIntegral(const cv::Mat& gray);
+            // `windowLabels` and `windowEdges` are filled on first use and shared across colours.
+            std::vector<cv::Rect> findCandidatesInWindow(FrameContext& ctx, const cv::Rect& window, QRColour colour,
+                                                         cv::Mat& windowLabels, cv::Mat& windowEdges) const;
+            cv::Rect predictSearchWindow(const cv::Size& frameSize, FrameContext::Clock::time_point now) const;
+            void rememberNearest(const std::vector<QRCode>& codes, FrameContext::Clock::time_point when);
+            void collectCodes(FrameContext& ctx, const std::vector<cv::Rect>& rois, QRColour colour, bool tryDecode, std::vector<QRCode>& out) const;
+
+            bool m_predictedRoiEnabled{ true };
+            int m_fullSearchInterval{ 10 };
+            int m_detectionsSinceFull{ 0 };
+            std::optional<cv::Rect> m_lastBox{};
+            cv::Point2f m_lastBoxVelocity{ 0.0f, 0.0f };  // px per second
+            FrameContext::Clock::time_point m_lastBoxTime{};
+            RoiSearchStats m_roiStats{};
+
+            static constexpr int EDGE_STEP{ 32 };
+            static constexpr float CODE_EDGE_DENSITY{ 0.15f };  // edge pixels per pixel at which a region looks fully code-like
+            static constexpr float CODE_MIN_FILL{ 0.5f };  // coloured modules cover at least about half a code
+            int m_maxCandidates{ 3 };
+            float m_minCandidateScore{ 0.1f };
+            mutable CandidateStats m_candidateStats{};
+
+            double m_maxDecodeUpscale{ 4.0 };
+
+            DetectResult robustDetectInROI(FrameContext& ctx, const cv::Rect& roi, bool tryDecode) const;
 
             static cv::Rect padRect(const cv::Rect& r, int pad, const cv::Size& maxSize);
             static bool isAspectOk(const cv::Rect& r, float low, float high);
             static float estimateDistancePxToMeters(float bboxPx, float referencePx, float referenceMeters);
             static float averageSide(const cv::Rect& r);
-            bool verifyColourInROI(const cv::Mat& frame, const cv::Rect& roi, QRColour colour) const;
+            bool verifyColourInROI(FrameContext& ctx, const cv::Rect& roi, QRColour colour) const;
         };
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "QRReader.h"
+#include "LatencyHistogram.h"
 
 #include <string>
 #include <iostream>
@@ -20,32 +21,63 @@ namespace NavigationVI {
         return gray;
     }
 
+    // ImageScanner setup is not free and a scanner can't be shared between
+    // threads, so each decoding thread keeps one configured for QR only.
+    namespace {
+        struct QRScanner {
+            zbar::ImageScanner scanner{};
+            QRScanner() {
+                scanner.set_config(zbar::ZBAR_NONE, zbar::ZBAR_CFG_ENABLE, 0);
+                scanner.set_config(zbar::ZBAR_QRCODE, zbar::ZBAR_CFG_ENABLE, 1);
+            }
+        };
+    }
+
+    static zbar::ImageScanner& threadScanner() {
+        thread_local QRScanner s{};
+        return s.scanner;
+    }
+
+    void QRReader::setLogLevel(LogLevel level) { m_logLevel = level; }
+    QRReader::LogLevel QRReader::getLogLevel() const { return m_logLevel; }
+
     std::string QRReader::printResult(const std::vector<zbar::Symbol>& zbarResults) const {
         std::string data{};
         for (const auto& symbol : zbarResults) {
-            std::string msg = "QR detected: " + symbol.get_data();
-            std::cout << msg << std::endl;
-            if (onMessage) onMessage(msg);
             data = symbol.get_data();
+            if (m_logLevel >= LogLevel::INFO) std::cout << "QR detected: " << data << std::endl;
+            if (onMessage) onMessage("QR detected: " + data);
         }
         return data;
     }
 
-    std::vector<zbar::Symbol> QRReader::decodeWithZbar(const cv::Mat& image, zbar::ImageScanner& scanner) const {
+    std::vector<zbar::Symbol> QRReader::decodeWithZbar(const cv::Mat& gray, zbar::ImageScanner& scanner) const {
         std::vector<zbar::Symbol> results{};
-        if (tooSmall(image, 8)) return results;
-        cv::Mat gray{};
-        if (image.channels() == 1) gray = image;
-        else cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
-        if (tooSmall(gray, 8)) return results;
+        if (tooSmall(gray, 8) || gray.type() != CV_8UC1) return results;
+
+        // Hand ZBar the pixels in place. A strided ROI view is described as an
+        // image as wide as its row step, starting at the left edge of the parent
+        // rows, and cropped back to the ROI.
+        const uchar* base{ gray.data };
+        unsigned width{ static_cast<unsigned>(gray.cols) };
+        unsigned cropX{ 0 };
+        if (!gray.isContinuous()) {
+            cv::Size whole{};
+            cv::Point ofs{};
+            gray.locateROI(whole, ofs);
+            base = gray.data - ofs.x;
+            width = static_cast<unsigned>(gray.step[0]);
+            cropX = static_cast<unsigned>(ofs.x);
+        }
 
         zbar::Image zbarImage(
-            gray.cols,
+            width,
             gray.rows,
             "Y800",
-            static_cast<void*>(const_cast<uchar*>(gray.data)),
-            gray.cols * gray.rows
+            base,
+            static_cast<unsigned long>(width) * gray.rows
         );
+        if (width != static_cast<unsigned>(gray.cols)) zbarImage.set_crop(cropX, 0, gray.cols, gray.rows);
 
         int n{ scanner.scan(zbarImage) };
         if (n > 0) {
@@ -58,12 +90,13 @@ namespace NavigationVI {
         return results;
     }
 
-    std::string QRReader::decodeQR(const cv::Mat& image, zbar::ImageScanner& scanner, const std::string& stageName) const {
-        if (tooSmall(image, 8)) return "";
-        std::vector<zbar::Symbol> results{ decodeWithZbar(image, scanner) };
+    std::string QRReader::decodeQR(const cv::Mat& gray, zbar::ImageScanner& scanner, const char* stageName) const {
+        if (tooSmall(gray, 8)) return "";
+        std::vector<zbar::Symbol> results{ decodeWithZbar(gray, scanner) };
         if (!results.empty()) {
-            std::cout << "\nZbar detected " << results.size()
-                << " Qr code(s) in " << stageName << std::endl;
+            if (m_logLevel >= LogLevel::DEBUG)
+                std::cout << "Zbar detected " << results.size()
+                    << " QR code(s) in " << stageName << std::endl;
             return printResult(results);
         }
         return "";
@@ -76,21 +109,19 @@ namespace NavigationVI {
         return threshold;
     }
 
-    std::string QRReader::reader(const cv::Mat& imageBGR) {
-        if (tooSmall(imageBGR, 12)) {
-            std::cout << "QRReader: empty or too small image, skipping." << std::endl;
+    std::string QRReader::reader(const cv::Mat& image) {
+        ScopedLatency timer{ LatencyStage::Decode };
+        if (tooSmall(image, 12)) {
+            if (m_logLevel >= LogLevel::DEBUG)
+                std::cout << "QRReader: empty or too small image, skipping." << std::endl;
             return "";
         }
 
-        zbar::ImageScanner scanner{};
-        scanner.set_config(zbar::ZBAR_NONE, zbar::ZBAR_CFG_ENABLE, 1);
-
-        {
-            std::string result{ decodeQR(imageBGR, scanner, "original image") };
-            if (!result.empty()) return result;
-        }
+        zbar::ImageScanner& scanner{ threadScanner() };
 
-        cv::Mat gray{ toGray(imageBGR) };
+        // One conversion shared by every stage; gray input (or a gray ROI view)
+        // is used as-is.
+        cv::Mat gray{ toGray(image) };
         if (tooSmall(gray, 12)) return "";
 
         {
@@ -126,7 +157,7 @@ namespace NavigationVI {
             if (!result.empty()) return result;
         }
 
-        std::cout << "\nZBar: No QR code detected" << std::endl;
+        if (m_logLevel >= LogLevel::DEBUG) std::cout << "ZBar: No QR code detected" << std::endl;
         // if (onMessage) onMessage("No QR code detected");
         return "";
     }
@@ -10,18 +10,26 @@
 namespace NavigationVI {
     class QRReader {
     public:
-        std::string reader(const cv::Mat& imageBGR);
+        enum class LogLevel { NONE, INFO, DEBUG };
+
+        // Accepts BGR, BGRA or gray input, including ROI views of a larger image.
+        std::string reader(const cv::Mat& image);
+
+        void setLogLevel(LogLevel level);
+        LogLevel getLogLevel() const;
     public:
         std::function<void(const std::string&)> onMessage{};
     private:
         cv::Mat toGray(const cv::Mat& image) const;
         //cv::Mat perspectiveCorrection(const cv::Mat& image) const;
         std::string printResult(const std::vector<zbar::Symbol>& zbarResults) const;
-        std::vector<zbar::Symbol> decodeWithZbar(const cv::Mat& image, zbar::ImageScanner& scanner) const;
-        std::string decodeQR(const cv::Mat& image,
+        std::vector<zbar::Symbol> decodeWithZbar(const cv::Mat& gray, zbar::ImageScanner& scanner) const;
+        std::string decodeQR(const cv::Mat& gray,
             zbar::ImageScanner& scanner,
-            const std::string& stageName) const;
+            const char* stageName) const;
         //cv::Mat applyUpscaling(const cv::Mat& image) const;
         cv::Mat thresholdImage(const cv::Mat& image) const;
+    private:
+        LogLevel m_logLevel{ LogLevel::NONE };
     };
 }
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "QRTracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace NavigationVI{
+    static double quadArea(const std::array<cv::Point2f, 4>& q){
+        double a{ 0.0 };
+        for (int i{ 0 }; i < 4; ++i){
+            const cv::Point2f& p{ q[i] };
+            const cv::Point2f& n{ q[(i + 1) % 4] };
+            a += static_cast<double>(p.x) * n.y - static_cast<double>(n.x) * p.y;
+        }
+        return std::fabs(a) * 0.5;
+    }
+
+    static cv::Rect quadBounds(const std::array<cv::Point2f, 4>& q){
+        std::vector<cv::Point2f> pts(q.begin(), q.end());
+        return cv::boundingRect(pts);
+    }
+
+    void QRTracker::reset(const QRCode& qr, const cv::Mat& gray, Clock::time_point now){
+        clear();
+        if (qr.corners.size() != 4 || gray.empty()) return;
+
+        m_code = qr;
+        gray.copyTo(m_prevGray);
+        for (int i{ 0 }; i < 4; ++i){
+            m_pos[i] = qr.corners[i];
+            m_vel[i] = cv::Point2f{ 0.0f, 0.0f };
+        }
+        m_initialArea = std::max(1.0, quadArea(m_pos));
+        m_lastUpdate = now;
+        m_confidence = 1.0f;
+        m_tracking = true;
+    }
+
+    void QRTracker::clear(){
+        m_tracking = false;
+        m_confidence = 0.0f;
+        m_trackedFrames = 0;
+    }
+
+    bool QRTracker::isTracking() const { return m_tracking; }
+    float QRTracker::confidence() const { return m_confidence; }
+
+    bool QRTracker::needsRedetect() const{
+        return !m_tracking || m_confidence < m_minConfidence || m_trackedFrames >= m_maxTrackedFrames;
+    }
+
+    void QRTracker::setContent(const std::string& content){ m_code.content = content; }
+    void QRTracker::setMinConfidence(float minConfidence){ m_minConfidence = minConfidence; }
+    void QRTracker::setMaxTrackedFrames(int frames){ m_maxTrackedFrames = std::max(1, frames); }
+
+    bool QRTracker::trackCorners(const cv::Mat& gray, std::array<cv::Point2f, 4>& measured, int& good) const{
+        good = 0;
+        if (gray.size() != m_prevGray.size()) return false;
+
+        // Only a window around the code is pyramided, not the whole frame.
+        cv::Rect box{ quadBounds(m_pos) };
+        int margin{ std::max(48, std::max(box.width, box.height) / 2) };
+        cv::Rect window{ box.x - margin, box.y - margin, box.width + 2 * margin, box.height + 2 * margin };
+        window &= cv::Rect{ 0, 0, gray.cols, gray.rows };
+        if (window.width < 16 || window.height < 16) return false;
+
+        cv::Point2f origin{ static_cast<float>(window.x), static_cast<float>(window.y) };
+        std::vector<cv::Point2f> prevPts{}, nextPts{}, backPts{};
+        for (const auto& p : m_pos) prevPts.push_back(p - origin);
+
+        std::vector<uchar> status{}, backStatus{};
+        std::vector<float> err{};
+        const cv::Size winSize{ 21, 21 };
+        const cv::TermCriteria criteria{ cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20, 0.03 };
+        cv::Mat prevWin{ m_prevGray(window) };
+        cv::Mat nextWin{ gray(window) };
+        cv::calcOpticalFlowPyrLK(prevWin, nextWin, prevPts, nextPts, status, err, winSize, 3, criteria);
+        cv::calcOpticalFlowPyrLK(nextWin, prevWin, nextPts, backPts, backStatus, err, winSize, 3, criteria);
+        if (nextPts.size() != 4 || backPts.size() != 4) return false;
+
+        std::array<bool, 4> ok{};
+        cv::Point2f shift{ 0.0f, 0.0f };
+        for (int i{ 0 }; i < 4; ++i){
+            ok[i] = status[i] && backStatus[i] && cv::norm(backPts[i] - prevPts[i]) <= FB_MAX_ERROR_PX;
+            if (!ok[i]) continue;
+            shift += nextPts[i] - prevPts[i];
+            ++good;
+        }
+        if (good == 0) return false;
+        shift *= 1.0f / good;
+
+        // Corners that failed the check follow the mean motion of the others.
+        for (int i{ 0 }; i < 4; ++i)
+            measured[i] = ok[i] ? nextPts[i] + origin : m_pos[i] + shift;
+        return true;
+    }
+
+    std::optional<QRCode> QRTracker::update(const cv::Mat& gray, Clock::time_point now){
+        if (!m_tracking || gray.empty()) return std::nullopt;
+
+        float dt{ std::chrono::duration<float>(now - m_lastUpdate).count() };
+        dt = std::max(dt, 1e-3f);
+
+        std::array<cv::Point2f, 4> measured{};
+        int good{ 0 };
+        if (!trackCorners(gray, measured, good) || good < 2){
+            clear();
+            return std::nullopt;
+        }
+
+        for (int i{ 0 }; i < 4; ++i){
+            cv::Point2f predicted{ m_pos[i] + m_vel[i] * dt };
+            cv::Point2f residual{ measured[i] - predicted };
+            m_pos[i] = predicted + residual * FILTER_ALPHA;
+            m_vel[i] += residual * (FILTER_BETA / dt);
+        }
+
+        // A folded or collapsing quad means the corners slid off the code.
+        std::vector<cv::Point> poly{};
+        for (const auto& p : m_pos) poly.emplace_back(cvRound(p.x), cvRound(p.y));
+        double area{ quadArea(m_pos) };
+        bool shapeOk{ cv::isContourConvex(poly) && area >= 0.25 * m_initialArea && area <= 4.0 * m_initialArea };
+
+        m_confidence = shapeOk ? static_cast<float>(good) / 4.0f : 0.0f;
+        gray.copyTo(m_prevGray);
+        m_lastUpdate = now;
+        ++m_trackedFrames;
+
+        if (!shapeOk){
+            clear();
+            return std::nullopt;
+        }
+        return currentCode();
+    }
+
+    QRCode QRTracker::currentCode() const{
+        QRCode qr{ m_code };
+        qr.corners.assign(m_pos.begin(), m_pos.end());
+
+        // Keep the padding the detector put around the corners.
+        cv::Rect initial{ cv::boundingRect(m_code.corners) };
+        int padX{ std::max(0, (m_code.bbox.width - initial.width) / 2) };
+        int padY{ std::max(0, (m_code.bbox.height - initial.height) / 2) };
+        cv::Rect box{ quadBounds(m_pos) };
+        box.x -= padX;
+        box.y -= padY;
+        box.width += 2 * padX;
+        box.height += 2 * padY;
+        box &= cv::Rect{ 0, 0, m_prevGray.cols, m_prevGray.rows };
+        qr.bbox = box;
+        qr.position = cv::Point2f{ box.x + box.width * 0.5f, box.y + box.height * 0.5f };
+
+        // Apparent size scales with 1/distance.
+        double area{ std::max(1.0, quadArea(m_pos)) };
+        qr.distance = m_code.distance * static_cast<float>(std::sqrt(m_initialArea / area));
+        return qr;
+    }
+}
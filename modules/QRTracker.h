@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <optional>
+
+#include <opencv2/opencv.hpp>
+
+#include "../utils/QRCode.h"
+
+namespace NavigationVI{
+    // Follows the last detected code between full detections. The four corners
+    // are tracked with pyramidal Lucas-Kanade inside a window around the code
+    // and smoothed by a constant-velocity (alpha-beta) filter, so the overlay
+    // and turn guidance can refresh every frame. Confidence combines how many
+    // corners pass a forward-backward check with how well the quad keeps its
+    // shape; once it drops (or the track gets old) the caller should run
+    // detectQRCodes again and reset().
+    class QRTracker{
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            QRTracker() = default;
+
+            void reset(const QRCode& qr, const cv::Mat& gray, Clock::time_point now);
+            void clear();
+
+            // Tracks into the next frame; nullopt once the code is lost.
+            std::optional<QRCode> update(const cv::Mat& gray, Clock::time_point now);
+
+            bool isTracking() const;
+            bool needsRedetect() const;
+            float confidence() const;
+
+            // Content decoded for the code being tracked, so it isn't decoded again.
+            void setContent(const std::string& content);
+
+            void setMinConfidence(float minConfidence);
+            void setMaxTrackedFrames(int frames);
+
+        private:
+            bool trackCorners(const cv::Mat& gray, std::array<cv::Point2f, 4>& measured, int& good) const;
+            QRCode currentCode() const;
+
+        private:
+            static constexpr float FB_MAX_ERROR_PX{ 1.5f };
+            static constexpr float FILTER_ALPHA{ 0.85f };
+            static constexpr float FILTER_BETA{ 0.3f };
+
+            bool m_tracking{ false };
+            float m_confidence{ 0.0f };
+            float m_minConfidence{ 0.6f };
+            int m_maxTrackedFrames{ 90 };
+            int m_trackedFrames{ 0 };
+
+            QRCode m_code{};
+            cv::Mat m_prevGray{};  // own copy: ring slots are refilled, and the buffer is reused
+            double m_initialArea{ 0.0 };
+            std::array<cv::Point2f, 4> m_pos{};
+            std::array<cv::Point2f, 4> m_vel{};  // px per second
+            Clock::time_point m_lastUpdate{};
+    };
+}
@@ -8,11 +8,18 @@
 #include "RouteGuidance.h"
 #include "./utils/Geometry.h"
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
 namespace NavigationVI {
+    namespace {
+        // Stitched route point. pathIdx is the room this point is the centre of
+        // (-1 for waypoints); turnIdx is cleared when de-duplication merged
+        // points, since the precomputed turn no longer matches the geometry.
+        struct RoutePoint {
+            Point p{};
+            int pathIdx{ -1 };
+            int turnIdx{ -1 };
+        };
+    }
+
     std::pair<double, double> RouteGuidance::pointSegmentDistance(
         const Point& p, const Point& a, const Point& b) const {
         double vx{ b.m_x - a.m_x };
@@ -35,29 +42,6 @@ namespace NavigationVI {
         return "ahead";
     }
 
-    std::optional<Room> RouteGuidance::roomAtPoint(const Point& p, const CoordinateMapSystem& map, double tol) const {
-        for (const auto& kv : map.getRooms()) {
-            if (kv.second.m_center.distanceTo(p) <= tol) return kv.second;
-        }
-        return std::nullopt;
-    }
-
-    double RouteGuidance::bearingDeg(const Point& a, const Point& b) const { return std::atan2(b.m_y - a.m_y, b.m_x - a.m_x) * 180.0 / M_PI; }
-
-    std::string RouteGuidance::turnPhrase(std::optional<double> prevBearing, double currBearing) const {
-        if (!prevBearing.has_value()) return "Head";
-
-        // Signed smallest difference in degrees, normalized to (−180, 180]
-        double diff = currBearing - prevBearing.value();
-        diff = std::fmod(diff + 540.0, 360.0) - 180.0; // normalize
-
-        double ad = std::fabs(diff);
-        if (ad < 15)   return "Continue straight";
-        if (ad < 45)   return diff > 0 ? "Slight left" : "Slight right";
-        if (ad < 135)  return diff > 0 ? "Turn left" : "Turn right";
-        return "Make a U-turn";
-    }
-
 
     double RouteGuidance::segmentDistanceM(const Point& a, const Point& b, double unitScale) const { return a.distanceTo(b) * unitScale; }
 
@@ -69,14 +53,16 @@ namespace NavigationVI {
         int steps,
         const CoordinateMapSystem& map,
         double stepLengthM) const {
-        if (!map.getRooms().count(aRoom) || !map.getRooms().count(bRoom) || steps <= 0) return 1.0;
-        double mapUnits{ map.getRooms().at(aRoom).m_center.distanceTo(map.getRooms().at(bRoom).m_center) };
+        auto a{ map.roomCenter(aRoom) };
+        auto b{ map.roomCenter(bRoom) };
+        if (!a || !b || steps <= 0) return 1.0;
+        double mapUnits{ a->distanceTo(*b) };
         double real_m{ steps * stepLengthM };
         return real_m / std::max(mapUnits, 1e-9);
     }
 
     std::pair<std::vector<Instruction>, std::map<std::string, double>>
-        RouteGuidance::pathToInstructions(CoordinateMapSystem map,
+        RouteGuidance::pathToInstructions(const CoordinateMapSystem& map,
             const std::string& startRoom,
             const std::string& goalRoom,
             double unitScale,
@@ -99,27 +85,38 @@ namespace NavigationVI {
             return { instrs, summary };
         }
 
-        std::vector<Point> pts{ map.stitchWayPoints(result.m_path) };
+        // Same points as stitchWayPoints, but each room centre remembers its
+        // place in the path so turns can be read from the map's turn table.
+        const auto& path{ result.m_path };
+        std::vector<RoutePoint> pts{};
+        auto pushPoint{ [&pts](const Point& p, int pathIdx) {
+            if (!pts.empty() && pts.back().p.distanceTo(p) <= 0.05f) {
+                if (pathIdx >= 0) pts.back().pathIdx = pathIdx;
+                pts.back().turnIdx = -1;
+                return;
+            }
+            pts.push_back(RoutePoint{ p, pathIdx, pathIdx });
+        } };
+        for (size_t j{ 0 }; j < path.size(); ++j) {
+            if (j > 0) {
+                auto c{ map.getConnection(path[j - 1], path[j]) };
+                if (c) for (const auto& wp : c->wayPoints) pushPoint(wp, -1);
+            }
+            auto centre{ map.roomCenter(path[j]) };
+            if (centre) pushPoint(*centre, static_cast<int>(j));
+        }
         if (pts.empty()) {
             instrs.emplace_back("No waypoints for path.");
             summary["found"] = 0.0;
             return { instrs, summary };
         }
 
-        std::vector<Point> dedup{};
-        dedup.push_back(pts.front());
-        for (size_t i{ 1 }; i < pts.size(); ++i) {
-            if (dedup.back().distanceTo(pts[i]) > 1e-6) dedup.push_back(pts[i]);
-        }
-        pts.swap(dedup);
-
         double total_m{ 0.0f };
         int total_steps{ 0 };
-        std::optional<double> prev_bearing{};
 
-        std::set<std::string> excludeLandmarks(result.m_path.begin(), result.m_path.end());
-        std::string startName{ map.getRooms().at(result.m_path.front()).m_name };
-        std::string goalName{ map.getRooms().at(result.m_path.back()).m_name };
+        std::set<std::string> excludeLandmarks(path.begin(), path.end());
+        std::string startName{ map.roomName(path.front()).value_or(path.front()) };
+        std::string goalName{ map.roomName(path.back()).value_or(path.back()) };
 
         instrs.emplace_back("Starting at " + startName + ".");
         if (onMessage) onMessage("Starting at " + startName + ".");
@@ -130,8 +127,8 @@ namespace NavigationVI {
         //};
 
         for (size_t i{ 0 }; i + 1 < pts.size(); ++i) {
-            const Point& a{ pts[i] };
-            const Point& b{ pts[i + 1] };
+            const Point& a{ pts[i].p };
+            const Point& b{ pts[i + 1].p };
 
             double seg_m_if_scaled{ a.distanceTo(b) * unitScale };
             int seg_steps{};
@@ -140,13 +137,23 @@ namespace NavigationVI {
 
             double approx_m{ seg_steps * stepLengthM };
 
-            double bearing{ bearingDeg(a, b) };
-            std::string action{ turnPhrase(prev_bearing, bearing) };
-            prev_bearing = bearing;
+            TurnType turn{ TurnType::HEAD };
+            if (i > 0) {
+                int j{ pts[i].turnIdx };
+                std::optional<TurnType> cached{};
+                if (j > 0 && j + 1 < static_cast<int>(path.size()))
+                    cached = map.turnAt(path[j - 1], path[j], path[j + 1]);
+                if (cached) turn = *cached;
+                else {
+                    const Point& prev{ pts[i - 1].p };
+                    turn = classifyTurn(a.m_x - prev.m_x, a.m_y - prev.m_y, b.m_x - a.m_x, b.m_y - a.m_y);
+                }
+            }
+            std::string action{ turnPhrase(turn) };
 
             std::string at_phrase{};
-            auto b_node{ roomAtPoint(b, map) };
-            if (b_node.has_value() && (anchorEverySegment || action != "Continue straight")) at_phrase = " to " + b_node->m_name;
+            if (pts[i + 1].pathIdx >= 0 && (anchorEverySegment || turn != TurnType::STRAIGHT))
+                at_phrase = " to " + map.roomName(path[pts[i + 1].pathIdx]).value_or(path[pts[i + 1].pathIdx]);
 
             /*std::optional<std::pair<Room, std::string>> lm{};
             if (i < pts.size() - 2) lm = segmentBestLandmark(a, b, includeTypes, landmarkRadius, excludeLandmarks, map);*/
@@ -174,7 +181,7 @@ namespace NavigationVI {
 
             //std::string text{ action + at_phrase + distance_phrase + landmark_phrase + "." };
             std::string text{ action + at_phrase + distance_phrase + "." };
-            instrs.emplace_back(text, approx_m, seg_steps);
+            instrs.emplace_back(text, approx_m, seg_steps, turn);
             if (onMessage) onMessage(text);
             total_m += approx_m;
             total_steps += seg_steps;
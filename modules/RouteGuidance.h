@@ -16,9 +16,10 @@ namespace NavigationVI {
         std::string text{};
         double distance_m{ 0.0f };
         int steps{ 0 };
+        std::optional<TurnType> turn{};  // unset for the start/arrive lines
         Instruction() = default;
-        Instruction(const std::string& t, double d = 0.0, int s = 0)
-            : text(t), distance_m(d), steps(s) {}
+        Instruction(const std::string& t, double d = 0.0, int s = 0, std::optional<TurnType> tt = std::nullopt)
+            : text(t), distance_m(d), steps(s), turn(tt) {}
     };
 
     class RouteGuidance {
@@ -26,7 +27,7 @@ namespace NavigationVI {
         RouteGuidance() = default;
 
         std::pair<std::vector<Instruction>, std::map<std::string, double>>
-            pathToInstructions(CoordinateMapSystem map,
+            pathToInstructions(const CoordinateMapSystem& map,
                 const std::string& startRoom,
                 const std::string& goalRoom,
                 double unitScale = 1.0,
@@ -43,9 +44,6 @@ namespace NavigationVI {
     private:
         std::pair<double, double> pointSegmentDistance(const Point& p, const Point& a, const Point& b) const;
         std::string sideOfPoint(const Point& p, const Point& a, const Point& b, double eps = 1e-6) const;
-        std::optional<Room> roomAtPoint(const Point& p, const CoordinateMapSystem& map, double tol = 1e-5) const;
-        double bearingDeg(const Point& a, const Point& b) const;
-        std::string turnPhrase(std::optional<double> prevBearing, double currBearing) const;
         double segmentDistanceM(const Point& a, const Point& b, double unitScale) const;
         double calibrateUnitScaleFromSteps(const std::string& aRoom, const std::string& bRoom,
             int steps, const CoordinateMapSystem& map, double stepLengthM = 0.75) const;
@@ -0,0 +1,178 @@
+#include "RoutePlanner.h"
+
+#include <algorithm>
+
+namespace NavigationVI{
+    static std::shared_future<PlannedRoute> cancelledFuture(const std::string& start, const std::string& goal){
+        std::promise<PlannedRoute> p{};
+        PlannedRoute route{};
+        route.startRoom = start;
+        route.goalRoom = goal;
+        route.cancelled = true;
+        p.set_value(std::move(route));
+        return p.get_future().share();
+    }
+
+    RoutePlanner::RoutePlanner(PlanFunction plan)
+        : m_plan(std::move(plan)) {
+        m_thread = std::thread(&RoutePlanner::worker, this);
+    }
+
+    RoutePlanner::~RoutePlanner(){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    void RoutePlanner::setDestination(const std::string& goalRoom){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (goalRoom == m_goalRoom) return;
+
+        ++m_generation;
+        for (auto& job : m_jobs){
+            PlannedRoute route{};
+            route.startRoom = job.startRoom;
+            route.goalRoom = job.goalRoom;
+            route.cancelled = true;
+            job.promise->set_value(std::move(route));
+        }
+        m_jobs.clear();
+        m_results.clear();
+        m_unclaimed.clear();
+        m_goalRoom = goalRoom;
+    }
+
+    std::string RoutePlanner::getDestination() const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_goalRoom;
+    }
+
+    std::shared_future<PlannedRoute> RoutePlanner::enqueueLocked(const std::string& startRoom, bool urgent){
+        Job job{ startRoom, m_goalRoom, m_generation, ++m_nextJob, std::make_shared<std::promise<PlannedRoute>>() };
+        auto future{ job.promise->get_future().share() };
+        m_results[startRoom] = Result{ future, job.id };
+        if (urgent) m_jobs.push_front(std::move(job));
+        else m_jobs.push_back(std::move(job));
+        m_cv.notify_one();
+        return future;
+    }
+
+    std::shared_future<PlannedRoute> RoutePlanner::plan(const std::string& startRoom){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_goalRoom.empty()) return cancelledFuture(startRoom, m_goalRoom);
+
+        auto it{ m_results.find(startRoom) };
+        if (it == m_results.end()) return enqueueLocked(startRoom, true);
+
+        if (m_unclaimed.erase(startRoom)) ++m_speculativeHits;
+
+        // Still queued behind other speculative work: move it to the front.
+        auto queued{ std::find_if(m_jobs.begin(), m_jobs.end(),
+            [&startRoom](const Job& j){ return j.startRoom == startRoom; }) };
+        if (queued != m_jobs.end() && queued != m_jobs.begin()){
+            Job job{ std::move(*queued) };
+            m_jobs.erase(queued);
+            m_jobs.push_front(std::move(job));
+        }
+        return it->second.future;
+    }
+
+    void RoutePlanner::speculate(const std::vector<std::string>& startRooms){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_goalRoom.empty()) return;
+
+        for (const auto& start : startRooms){
+            if (m_results.count(start)) continue;
+            enqueueLocked(start, false);
+            m_unclaimed.insert(start);
+            ++m_speculativeRequests;
+        }
+    }
+
+    void RoutePlanner::invalidate(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Partition loads happen inside m_plan on the worker; the route it is
+        // planning already sees them, so only a change from another thread stales it.
+        if (m_runningJob != 0 && std::this_thread::get_id() != m_thread.get_id()) m_runningStale = true;
+
+        for (auto it{ m_results.begin() }; it != m_results.end();){
+            bool queued{ std::any_of(m_jobs.begin(), m_jobs.end(),
+                [&it](const Job& j){ return j.id == it->second.job; }) };
+            if (queued || it->second.job == m_runningJob){
+                ++it;
+                continue;
+            }
+            m_unclaimed.erase(it->first);
+            it = m_results.erase(it);
+        }
+    }
+
+    void RoutePlanner::forgetLocked(const Job& job){
+        auto it{ m_results.find(job.startRoom) };
+        if (it == m_results.end() || it->second.job != job.id) return;
+        m_results.erase(it);
+        m_unclaimed.erase(job.startRoom);
+    }
+
+    std::size_t RoutePlanner::speculativeHits() const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_speculativeHits;
+    }
+
+    std::size_t RoutePlanner::speculativeRequests() const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_speculativeRequests;
+    }
+
+    void RoutePlanner::worker(){
+        while (true){
+            Job job{};
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+                if (m_stopping) break;
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+                m_runningJob = job.id;
+                m_runningStale = false;
+            }
+
+            PlannedRoute route{};
+            try{
+                route = m_plan(job.startRoom, job.goalRoom);
+            } catch (...){
+                {
+                    // Don't cache the failure; the next plan() for this start retries.
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    forgetLocked(job);
+                    m_runningJob = 0;
+                }
+                job.promise->set_exception(std::current_exception());
+                continue;
+            }
+            route.startRoom = job.startRoom;
+            route.goalRoom = job.goalRoom;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                // The destination changed while we were planning.
+                if (job.generation != m_generation) route.cancelled = true;
+                // Whoever is waiting still gets this route, but it isn't reused.
+                else if (m_runningStale) forgetLocked(job);
+                m_runningJob = 0;
+            }
+            job.promise->set_value(std::move(route));
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& job : m_jobs){
+            PlannedRoute route{};
+            route.cancelled = true;
+            job.promise->set_value(std::move(route));
+        }
+        m_jobs.clear();
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RouteGuidance.h"
+
+namespace NavigationVI{
+    struct PlannedRoute{
+        std::string startRoom{};
+        std::string goalRoom{};
+        std::vector<Instruction> instructions{};
+        std::map<std::string, double> summary{};
+        bool cancelled{ false };
+    };
+
+    // Plans routes on a background thread so detection never waits on A* or
+    // instruction rendering. Besides explicit requests it precomputes routes
+    // from anchors next to the user (speculate), so the next scan usually finds
+    // its instructions ready. Changing the destination cancels everything queued
+    // and discards in-flight results for the old destination.
+    class RoutePlanner{
+        public:
+            using PlanFunction = std::function<PlannedRoute(const std::string& start, const std::string& goal)>;
+
+            explicit RoutePlanner(PlanFunction plan);
+            ~RoutePlanner();
+
+            RoutePlanner(const RoutePlanner&) = delete;
+            RoutePlanner& operator=(const RoutePlanner&) = delete;
+
+            void setDestination(const std::string& goalRoom);
+            std::string getDestination() const;
+
+            // Returns the cached/in-flight result when one exists, otherwise queues
+            // the request ahead of any speculative work.
+            std::shared_future<PlannedRoute> plan(const std::string& startRoom);
+            void speculate(const std::vector<std::string>& startRooms);
+
+            // Drops finished routes after the map changed (partitions loaded or
+            // evicted, accessibility toggled). Queued jobs stay; a route being planned
+            // on another thread is dropped once it finishes, so the next plan() for
+            // that start re-runs against the new map.
+            void invalidate();
+
+            std::size_t speculativeHits() const;
+            std::size_t speculativeRequests() const;
+
+        private:
+            struct Job{
+                std::string startRoom{};
+                std::string goalRoom{};
+                std::uint64_t generation{ 0 };
+                std::uint64_t id{ 0 };
+                std::shared_ptr<std::promise<PlannedRoute>> promise{};
+            };
+
+            struct Result{
+                std::shared_future<PlannedRoute> future{};
+                std::uint64_t job{ 0 };
+            };
+
+            void worker();
+            std::shared_future<PlannedRoute> enqueueLocked(const std::string& startRoom, bool urgent);
+            void forgetLocked(const Job& job);
+
+        private:
+            PlanFunction m_plan{};
+
+            mutable std::mutex m_mutex{};
+            std::condition_variable m_cv{};
+            std::deque<Job> m_jobs{};
+            std::map<std::string, Result> m_results{};  // keyed by start room
+            std::string m_goalRoom{};
+            std::uint64_t m_generation{ 0 };
+            std::uint64_t m_nextJob{ 0 };
+            std::uint64_t m_runningJob{ 0 };    // 0 when idle
+            bool m_runningStale{ false };       // map changed under the running job
+            bool m_stopping{ false };
+
+            std::size_t m_speculativeRequests{ 0 };
+            std::size_t m_speculativeHits{ 0 };
+            std::set<std::string> m_unclaimed{};  // speculative results nobody has asked for yet
+
+            std::thread m_thread{};
+    };
+}
@@ -0,0 +1,83 @@
+// Compares the HSV inRange colour mask with the BGR lookup-table mask, and
+// masking every colour separately with cutting them from one labelling pass.
+//
+//   colour_mask_bench [image] [iterations]
+//
+// Without an image a synthetic 1280x720 frame (noise plus red/green/blue
+// squares) is used. Prints ms/frame for each path and how many mask pixels
+// agree after morphology.
+#include <iostream>
+#include <string>
+
+#include <opencv2/opencv.hpp>
+
+#include "../modules/QRDetector.h"
+
+using namespace NavigationVI;
+
+static cv::Mat syntheticFrame(){
+    cv::Mat frame(720, 1280, CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::rectangle(frame, cv::Rect(100, 100, 200, 200), cv::Scalar(40, 40, 200), cv::FILLED);
+    cv::rectangle(frame, cv::Rect(500, 200, 200, 200), cv::Scalar(40, 180, 40), cv::FILLED);
+    cv::rectangle(frame, cv::Rect(900, 300, 200, 200), cv::Scalar(200, 60, 30), cv::FILLED);
+    return frame;
+}
+
+template <typename F>
+static double msPerCall(int iterations, F&& fn){
+    int64_t start{ cv::getTickCount() };
+    for (int i{ 0 }; i < iterations; ++i) fn();
+    return (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency() / iterations;
+}
+
+int main(int argc, char** argv){
+    cv::Mat frame{ argc > 1 ? cv::imread(argv[1]) : syntheticFrame() };
+    if (frame.empty()){
+        std::cerr << "Failed to read " << argv[1] << "\n";
+        return 1;
+    }
+    int iterations{ argc > 2 ? std::stoi(argv[2]) : 200 };
+
+    QRDetector detector{};
+    const std::pair<const char*, QRColour> colours[]{
+        { "red", QRColour::RED }, { "green", QRColour::GREEN }, { "blue", QRColour::BLUE }
+    };
+
+    std::cout << frame.cols << "x" << frame.rows << ", " << iterations << " iterations\n";
+    for (const auto& [name, colour] : colours){
+        cv::Mat hsvMask{}, lutMask{};
+        double hsvMs{ msPerCall(iterations, [&] {
+            cv::Mat hsv{};
+            cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+            hsvMask = detector.makeColourMask(hsv, colour);
+        }) };
+        double lutMs{ msPerCall(iterations, [&] { lutMask = detector.makeColourMaskBGR(frame, colour); }) };
+
+        cv::Mat diff{};
+        cv::compare(hsvMask, lutMask, diff, cv::CMP_NE);
+        double agree{ 100.0 * (1.0 - static_cast<double>(cv::countNonZero(diff)) / diff.total()) };
+
+        std::cout << name << ": hsv " << hsvMs << " ms, lut " << lutMs << " ms ("
+                  << hsvMs / std::max(lutMs, 1e-9) << "x), " << agree << "% pixels agree\n";
+    }
+
+    // All three colours: three table passes against one.
+    double separateMs{ msPerCall(iterations, [&] {
+        for (const auto& c : colours) detector.makeColourMaskBGR(frame, c.second);
+    }) };
+    double labelledMs{ msPerCall(iterations, [&] {
+        cv::Mat labels{ detector.labelColoursBGR(frame) };
+        for (const auto& c : colours) QRDetector::maskFromLabels(labels, c.second);
+    }) };
+    std::size_t mismatched{ 0 };
+    cv::Mat labels{ detector.labelColoursBGR(frame) };
+    for (const auto& c : colours) {
+        cv::Mat diff{};
+        cv::compare(detector.makeColourMaskBGR(frame, c.second), QRDetector::maskFromLabels(labels, c.second), diff, cv::CMP_NE);
+        mismatched += static_cast<std::size_t>(cv::countNonZero(diff));
+    }
+    std::cout << "all colours: separate " << separateMs << " ms, one pass " << labelledMs << " ms ("
+              << separateMs / std::max(labelledMs, 1e-9) << "x), " << mismatched << " pixels differ\n";
+    return 0;
+}
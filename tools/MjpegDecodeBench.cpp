@@ -0,0 +1,53 @@
+// Times MjpegSource decoding of a recorded MJPEG file at each DCT scale and
+// the full-resolution decode of a centred 256x256 region.
+//
+//   mjpeg_decode_bench recording.mjpeg [max frames]
+//
+// Record one from the camera with e.g.
+//   gst-launch-1.0 v4l2src num-buffers=300 ! image/jpeg,width=1280,height=720 ! filesink location=rec.mjpeg
+#include <iostream>
+#include <string>
+
+#include <opencv2/opencv.hpp>
+
+#include "../modules/MjpegSource.h"
+
+using namespace NavigationVI;
+
+int main(int argc, char** argv){
+    if (argc < 2){
+        std::cerr << "Usage: mjpeg_decode_bench recording.mjpeg [max frames]\n";
+        return 1;
+    }
+    int maxFrames{ argc > 2 ? std::stoi(argv[2]) : 1000 };
+
+    for (int denom : { 1, 2, 4 }){
+        auto source{ MjpegSource::fromFile(argv[1], denom) };
+        if (!source->isOpened()) return 1;
+
+        int frames{ 0 };
+        double regionMs{ 0.0 };
+        int64_t start{ cv::getTickCount() };
+        while (frames < maxFrames){
+            auto ctx{ source->read() };
+            if (!ctx) break;
+            ++frames;
+
+            cv::Size s{ ctx->size() };
+            cv::Rect centre{ s.width / 2 - 128 / denom, s.height / 2 - 128 / denom, 256 / denom, 256 / denom };
+            int64_t regionStart{ cv::getTickCount() };
+            cv::Mat region{ ctx->fullResolutionRegion(centre) };
+            regionMs += (cv::getTickCount() - regionStart) * 1000.0 / cv::getTickFrequency();
+        }
+        double totalMs{ (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency() };
+        if (frames == 0){
+            std::cerr << "No frames in " << argv[1] << "\n";
+            return 1;
+        }
+
+        std::cout << "1/" << denom << ": " << frames << " frames, "
+                  << (totalMs - regionMs) / frames << " ms/frame decode, "
+                  << regionMs / frames << " ms/frame 256x256 full-res region\n";
+    }
+    return 0;
+}
@@ -46,6 +46,13 @@ namespace NavigationVI{
         float width{ 2.0 };
     };
 
+    // One line of connections.txt before distances are resolved.
+    struct ConnectionRecord{
+        std::string fromRoom{};
+        std::string toRoom{};
+        std::string pathwayType{};
+    };
+
     struct Room{
         std::string m_id{};
         std::string m_name{};
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 
 #include "Geometry.h"
 
@@ -13,4 +14,48 @@ namespace NavigationVI{
         bool m_found{};
         float m_executionTime{};
     };
-}
\ No newline at end of file
+
+    enum class TurnType : std::uint8_t{
+        HEAD,
+        STRAIGHT,
+        SLIGHT_LEFT,
+        SLIGHT_RIGHT,
+        LEFT,
+        RIGHT,
+        U_TURN
+    };
+
+    // Same bands as the old bearing-based turnPhrase (15/45/135 degrees, left is
+    // counter-clockwise) but from dot/cross products, so no atan2/fmod and usable
+    // in constexpr tables. Exact 45 and 135 degree corners (common on the 5-unit
+    // grid the map is drawn on) are both a plain turn; the atan2 version decided
+    // those by rounding noise and said "turn" for most of them.
+    constexpr TurnType classifyTurn(float inDx, float inDy, float outDx, float outDy){
+        constexpr float COS2_15{ 0.9330127f };   // cos^2(15 deg)
+        constexpr float COS2_45{ 0.5f };         // cos^2(45 deg) == cos^2(135 deg)
+
+        float dot{ inDx * outDx + inDy * outDy };
+        float cross{ inDx * outDy - inDy * outDx };
+        float norms{ (inDx * inDx + inDy * inDy) * (outDx * outDx + outDy * outDy) };
+        float dot2{ dot * dot };
+        bool left{ cross > 0.0f };
+
+        if (dot > 0.0f && dot2 > COS2_15 * norms) return TurnType::STRAIGHT;
+        if (dot > 0.0f && dot2 > COS2_45 * norms) return left ? TurnType::SLIGHT_LEFT : TurnType::SLIGHT_RIGHT;
+        if (dot >= 0.0f || dot2 <= COS2_45 * norms) return left ? TurnType::LEFT : TurnType::RIGHT;
+        return TurnType::U_TURN;
+    }
+
+    constexpr const char* turnPhrase(TurnType turn){
+        switch (turn){
+            case TurnType::HEAD: return "Head";
+            case TurnType::STRAIGHT: return "Continue straight";
+            case TurnType::SLIGHT_LEFT: return "Slight left";
+            case TurnType::SLIGHT_RIGHT: return "Slight right";
+            case TurnType::LEFT: return "Turn left";
+            case TurnType::RIGHT: return "Turn right";
+            case TurnType::U_TURN: return "Make a U-turn";
+            default: return "";
+        }
+    }
+}
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "MapEntities.h"
+#include "RouteTypes.h"
+
+namespace NavigationVI{
+    // Room record as emitted by cmake/EmbedMap.cmake. Centre is (m_x, m_y),
+    // matching CoordinateMapSystem::loadRoomsFromFile.
+    struct StaticRoom{
+        std::string_view m_id{};
+        std::string_view m_name{};
+        RoomType m_RoomType{};
+        float m_x{};
+        float m_y{};
+        float m_width{};
+        float m_height{};
+    };
+
+    // Undirected connection between two indices into the room table.
+    struct StaticEdgeRef{
+        std::uint16_t from{};
+        std::uint16_t to{};
+    };
+
+    // Non-owning view over a compiled-in map. Rooms are sorted by id, the
+    // adjacency is CSR (row i is adjacency[rowOffsets[i] .. rowOffsets[i+1]))
+    // and nameIndex holds room indices sorted by case-insensitive name.
+    struct StaticMapView{
+        const StaticRoom* rooms{ nullptr };
+        std::size_t roomCount{ 0 };
+        const std::uint32_t* rowOffsets{ nullptr };
+        const std::uint16_t* adjacency{ nullptr };
+        const float* edgeCosts{ nullptr };
+        const std::uint16_t* nameIndex{ nullptr };
+        const std::uint16_t* componentLabels{ nullptr };  // connected component per room
+        // Row-major deg x deg turn per room: turns[turnOffsets[v] + in * deg + out],
+        // where in/out are positions within v's adjacency row.
+        const std::uint32_t* turnOffsets{ nullptr };
+        const TurnType* turns{ nullptr };
+
+        bool empty() const { return rooms == nullptr || roomCount == 0; }
+        std::optional<std::uint16_t> findById(std::string_view id) const;
+        std::optional<std::uint16_t> findByName(std::string_view name) const;
+    };
+
+    namespace StaticMapDetail{
+        constexpr char toLower(char c){
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        constexpr int compareIgnoreCase(std::string_view a, std::string_view b){
+            std::size_t n{ a.size() < b.size() ? a.size() : b.size() };
+            for (std::size_t i{ 0 }; i < n; ++i){
+                char ca{ toLower(a[i]) };
+                char cb{ toLower(b[i]) };
+                if (ca != cb) return ca < cb ? -1 : 1;
+            }
+            if (a.size() == b.size()) return 0;
+            return a.size() < b.size() ? -1 : 1;
+        }
+
+        // std::sqrt is not constexpr before C++26; Newton iterations are plenty
+        // for map-scale distances.
+        constexpr float sqrtNewton(float v){
+            if (v <= 0.0f) return 0.0f;
+            float x{ v > 1.0f ? v : 1.0f };
+            for (int i{ 0 }; i < 64; ++i){
+                float next{ 0.5f * (x + v / x) };
+                if (next == x) break;
+                x = next;
+            }
+            return x;
+        }
+
+        template <std::size_t N>
+        constexpr bool isSortedById(const StaticRoom (&rooms)[N]){
+            for (std::size_t i{ 1 }; i < N; ++i){
+                if (!(rooms[i - 1].m_id < rooms[i].m_id)) return false;
+            }
+            return true;
+        }
+    }
+
+    template <std::size_t N, std::size_t E>
+    struct StaticGraph{
+        std::array<std::uint32_t, N + 1> rowOffsets{};
+        std::array<std::uint16_t, 2 * E> adjacency{};
+        std::array<float, 2 * E> edgeCosts{};
+        std::array<std::uint16_t, N> nameIndex{};
+        std::array<std::uint16_t, N> componentLabels{};
+        std::size_t componentCount{ 0 };
+    };
+
+    // Builds the CSR adjacency, per-edge costs and name index at compile time.
+    // Row order follows CoordinateMapSystem::addConnection: each connection is
+    // appended to its source row and its reverse to the target row, in file order.
+    template <std::size_t N, std::size_t E>
+    constexpr StaticGraph<N, E> buildStaticGraph(
+        const StaticRoom (&rooms)[N],
+        const StaticEdgeRef (&edges)[E]){
+
+        StaticGraph<N, E> g{};
+
+        std::array<std::uint32_t, N> degree{};
+        for (std::size_t e{ 0 }; e < E; ++e){
+            ++degree[edges[e].from];
+            ++degree[edges[e].to];
+        }
+        for (std::size_t i{ 0 }; i < N; ++i) g.rowOffsets[i + 1] = g.rowOffsets[i] + degree[i];
+
+        std::array<std::uint32_t, N> cursor{};
+        for (std::size_t i{ 0 }; i < N; ++i) cursor[i] = g.rowOffsets[i];
+
+        for (std::size_t e{ 0 }; e < E; ++e){
+            const StaticRoom& a{ rooms[edges[e].from] };
+            const StaticRoom& b{ rooms[edges[e].to] };
+            float dx{ a.m_x - b.m_x };
+            float dy{ a.m_y - b.m_y };
+            float cost{ StaticMapDetail::sqrtNewton(dx * dx + dy * dy) };
+
+            std::uint32_t fwd{ cursor[edges[e].from]++ };
+            g.adjacency[fwd] = edges[e].to;
+            g.edgeCosts[fwd] = cost;
+
+            std::uint32_t rev{ cursor[edges[e].to]++ };
+            g.adjacency[rev] = edges[e].from;
+            g.edgeCosts[rev] = cost;
+        }
+
+        for (std::size_t i{ 0 }; i < N; ++i) g.nameIndex[i] = static_cast<std::uint16_t>(i);
+        for (std::size_t i{ 1 }; i < N; ++i){
+            std::uint16_t key{ g.nameIndex[i] };
+            std::size_t j{ i };
+            while (j > 0 && StaticMapDetail::compareIgnoreCase(
+                    rooms[g.nameIndex[j - 1]].m_name, rooms[key].m_name) > 0){
+                g.nameIndex[j] = g.nameIndex[j - 1];
+                --j;
+            }
+            g.nameIndex[j] = key;
+        }
+
+        // Component labels by flood fill, so "no path" answers need no search.
+        constexpr std::uint16_t unlabelled{ 0xFFFF };
+        for (std::size_t i{ 0 }; i < N; ++i) g.componentLabels[i] = unlabelled;
+        std::array<std::uint16_t, N> stack{};
+        for (std::size_t seed{ 0 }; seed < N; ++seed){
+            if (g.componentLabels[seed] != unlabelled) continue;
+            std::uint16_t label{ static_cast<std::uint16_t>(g.componentCount++) };
+            std::size_t top{ 0 };
+            stack[top++] = static_cast<std::uint16_t>(seed);
+            g.componentLabels[seed] = label;
+            while (top > 0){
+                std::uint16_t u{ stack[--top] };
+                for (std::uint32_t e{ g.rowOffsets[u] }; e < g.rowOffsets[u + 1]; ++e){
+                    std::uint16_t v{ g.adjacency[e] };
+                    if (g.componentLabels[v] != unlabelled) continue;
+                    g.componentLabels[v] = label;
+                    stack[top++] = v;
+                }
+            }
+        }
+
+        return g;
+    }
+
+    template <std::size_t N, std::size_t T>
+    struct StaticTurnTable{
+        std::array<std::uint32_t, N + 1> turnOffsets{};
+        std::array<TurnType, T> turns{};
+    };
+
+    // Size of the turn table: sum of squared degrees.
+    template <std::size_t N, std::size_t E>
+    constexpr std::size_t countTurnPairs(const StaticGraph<N, E>& g){
+        std::size_t total{ 0 };
+        for (std::size_t i{ 0 }; i < N; ++i){
+            std::size_t deg{ g.rowOffsets[i + 1] - g.rowOffsets[i] };
+            total += deg * deg;
+        }
+        return total;
+    }
+
+    template <std::size_t T, std::size_t N, std::size_t E>
+    constexpr StaticTurnTable<N, T> buildTurnTable(
+        const StaticRoom (&rooms)[N],
+        const StaticGraph<N, E>& g){
+
+        StaticTurnTable<N, T> t{};
+        for (std::size_t v{ 0 }; v < N; ++v){
+            std::uint32_t begin{ g.rowOffsets[v] };
+            std::uint32_t deg{ g.rowOffsets[v + 1] - begin };
+            t.turnOffsets[v + 1] = t.turnOffsets[v] + deg * deg;
+
+            for (std::uint32_t i{ 0 }; i < deg; ++i){
+                const StaticRoom& from{ rooms[g.adjacency[begin + i]] };
+                float inDx{ rooms[v].m_x - from.m_x };
+                float inDy{ rooms[v].m_y - from.m_y };
+                for (std::uint32_t j{ 0 }; j < deg; ++j){
+                    const StaticRoom& to{ rooms[g.adjacency[begin + j]] };
+                    t.turns[t.turnOffsets[v] + i * deg + j] =
+                        classifyTurn(inDx, inDy, to.m_x - rooms[v].m_x, to.m_y - rooms[v].m_y);
+                }
+            }
+        }
+        return t;
+    }
+
+    template <std::size_t N, std::size_t E, std::size_t T>
+    constexpr StaticMapView makeStaticMapView(
+        const StaticRoom (&rooms)[N],
+        const StaticGraph<N, E>& g,
+        const StaticTurnTable<N, T>& t){
+        return StaticMapView{
+            rooms,
+            N,
+            g.rowOffsets.data(),
+            g.adjacency.data(),
+            g.edgeCosts.data(),
+            g.nameIndex.data(),
+            g.componentLabels.data(),
+            t.turnOffsets.data(),
+            t.turns.data()
+        };
+    }
+
+    inline std::optional<std::uint16_t> StaticMapView::findById(std::string_view id) const{
+        std::size_t lo{ 0 }, hi{ roomCount };
+        while (lo < hi){
+            std::size_t mid{ lo + (hi - lo) / 2 };
+            if (rooms[mid].m_id < id) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo < roomCount && rooms[lo].m_id == id) return static_cast<std::uint16_t>(lo);
+        return std::nullopt;
+    }
+
+    inline std::optional<std::uint16_t> StaticMapView::findByName(std::string_view name) const{
+        std::size_t lo{ 0 }, hi{ roomCount };
+        while (lo < hi){
+            std::size_t mid{ lo + (hi - lo) / 2 };
+            if (StaticMapDetail::compareIgnoreCase(rooms[nameIndex[mid]].m_name, name) < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo < roomCount && StaticMapDetail::compareIgnoreCase(rooms[nameIndex[lo]].m_name, name) == 0)
+            return nameIndex[lo];
+        return std::nullopt;
+    }
+}